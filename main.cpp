@@ -12,15 +12,41 @@
 #include <vector>
 #include <algorithm>
 #include <map>
+#include <unordered_map>
 #include <cmath>
 #include <ctime>
 #include <cstdlib>
 #include <iomanip>
+#include <memory>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <queue>
+#include <sstream>
+#include <charconv>
+#include <cstring>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <cctype>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define HAVE_X86_SIMD 1
+#endif
 
 using namespace std;
 
-const int MAXN = 55;    // 最大节点数
 const int INF = 1e9;    // 定义无穷大，用于初始化距离矩阵，表示不可达
+                        // 2 * INF 仍不溢出 int，INF 参与加法后的结果不会小于任何已知距离
 
 struct Node {
     int id;
@@ -39,18 +65,180 @@ struct Task {
     
     // 模拟状态
     vector<int> path;   // 存储从起点到终点的具体路径节点序列
+    vector<int> path_link;  // path 中每一跳经过的链路编号（见 LinkIndex）
     size_t path_idx;    // 当前处于路径数组的索引位置
     int current_pos_node;   // 模拟过程中，任务当前所在的节点
     bool finished;          // 标记任务是否已经到达终点
 };
 
+struct Link {
+    int u, v;
+    int cost;           // 单位迁移成本
+    int bandwidth;      // 每个时间步可同时通过的任务数
+};
+
+// 稠密整数矩阵
+// 按行主序连续存放，整块内存 64 字节对齐（与缓存行一致），
+// 每行长度向上填充到 16 个 int 的倍数，保证每一行的起始地址同样对齐，便于向量化。
+// 节点编号从 1 开始，第 0 行/列作为不可达的哑节点保留。
+// 存储既可以自行分配，也可以接管外部内存（例如 mmap 映射的缓存文件），由 owner 负责释放。
+class IntMatrix {
+public:
+    static const int ALIGN = 64;
+    static const int LANES = ALIGN / sizeof(int);   // 一个缓存行能放下的 int 个数
+
+    static int strideFor(int n) { return (n + 1 + LANES - 1) / LANES * LANES; }
+
+    void assign(int n, int fill) {
+        n_ = n;
+        stride_ = strideFor(n);
+        size_t bytes = (size_t)(n + 1) * stride_ * sizeof(int);
+        int* p = static_cast<int*>(aligned_alloc(ALIGN, bytes));
+        if (!p) throw bad_alloc();
+        data_.reset(p, free);
+        std::fill(p, p + (size_t)(n + 1) * stride_, fill);
+    }
+
+    // 接管一块已按本类布局填好的外部内存，要求 64 字节对齐
+    void adopt(int n, shared_ptr<int> owner) {
+        n_ = n;
+        stride_ = strideFor(n);
+        data_ = move(owner);
+    }
+
+    int* operator[](int i) { return data_.get() + (size_t)i * stride_; }
+    const int* operator[](int i) const { return data_.get() + (size_t)i * stride_; }
+
+    int size() const { return n_; }         // 有效节点数
+    int stride() const { return stride_; }  // 每行实际长度（含填充）
+
+private:
+    shared_ptr<int> data_;
+    int n_ = 0;
+    int stride_ = 0;
+};
+
+// 线程池
+// 常驻工作线程，parallelFor 把区间切块后由工作线程与调用线程共同领取执行，
+// 所有块完成后才返回。每个下标只由一个线程处理，只要各块写入互不重叠，
+// 结果与串行执行完全相同。不可在任务内部嵌套调用 parallelFor。
+class ThreadPool {
+public:
+    ~ThreadPool() { resize(1); }
+
+    // 设置总线程数（含调用线程），threads <= 0 表示使用全部硬件线程
+    void resize(int threads) {
+        if (threads <= 0) threads = max(1u, thread::hardware_concurrency());
+        {
+            lock_guard<mutex> lk(mu_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        for (auto& w : workers_) w.join();
+        workers_.clear();
+        stop_ = false;
+        // 新线程从当前代次开始等待，避免错过在其启动前已发布的任务
+        unsigned long long gen = generation_;
+        for (int i = 1; i < threads; ++i) workers_.emplace_back([this, gen] { workerLoop(gen); });
+    }
+
+    int size() const { return (int)workers_.size() + 1; }
+
+    // 并行执行 fn(lo, hi)，覆盖 [begin, end)；grain 为每块大小，0 表示自动
+    void parallelFor(int begin, int end, const function<void(int, int)>& fn, int grain = 0) {
+        if (end <= begin) return;
+        if (grain <= 0) grain = max(1, (end - begin) / (4 * size()));
+        if (workers_.empty() || end - begin <= grain) {
+            fn(begin, end);
+            return;
+        }
+        {
+            lock_guard<mutex> lk(mu_);
+            job_ = &fn;
+            end_ = end;
+            grain_ = grain;
+            next_.store(begin);
+            busy_ = (int)workers_.size();
+            ++generation_;
+        }
+        wake_.notify_all();
+        runChunks();
+        unique_lock<mutex> lk(mu_);
+        done_.wait(lk, [this] { return busy_ == 0; });
+        job_ = nullptr;
+    }
+
+private:
+    void runChunks() {
+        for (;;) {
+            int lo = next_.fetch_add(grain_);
+            if (lo >= end_) break;
+            (*job_)(lo, min(lo + grain_, end_));
+        }
+    }
+
+    void workerLoop(unsigned long long seen) {
+        unique_lock<mutex> lk(mu_);
+        for (;;) {
+            wake_.wait(lk, [&] { return stop_ || generation_ != seen; });
+            if (stop_) return;
+            seen = generation_;
+            lk.unlock();
+            runChunks();
+            lk.lock();
+            if (--busy_ == 0) done_.notify_one();
+        }
+    }
+
+    vector<thread> workers_;
+    mutex mu_;
+    condition_variable wake_, done_;
+    const function<void(int, int)>* job_ = nullptr;
+    int end_ = 0;
+    int grain_ = 1;
+    atomic<int> next_{0};
+    int busy_ = 0;
+    unsigned long long generation_ = 0;
+    bool stop_ = false;
+};
+
 // 全局数据
 int N, M, T;            // N:节点数, M:边数, T:任务数
-Node nodes[MAXN];       // 存储所有节点信息的数组
-int adj_bandwidth[MAXN][MAXN];  // 邻接矩阵：存储直接连接的带宽
-int dist[MAXN][MAXN];           // 距离矩阵：存储两点间最短路径的成本
-int next_hop[MAXN][MAXN];       // 路由表：从节点 i 到 j 的最短路径上，下一节点是谁
-vector<Task> tasks;             // 任务列表
+vector<Node> nodes;     // 存储所有节点信息的数组（下标即节点编号）
+IntMatrix adj_bandwidth;    // 邻接矩阵：存储直接连接的带宽
+IntMatrix dist;             // 距离矩阵：存储两点间最短路径的成本
+IntMatrix next_hop;         // 路由表：从节点 i 到 j 的最短路径上，下一节点是谁
+vector<Link> links;         // 输入的链路列表（保留重复边）
+vector<Task> tasks;         // 任务列表
+ThreadPool pool;            // 并行计算使用的线程池
+
+// 运行参数（由命令行解析）
+struct Options {
+    string apsp = "auto";       // 最短路引擎: auto / classic / blocked / dijkstra / lazy
+    string simd = "auto";       // 最小加松弛内核: auto / scalar / avx2 / avx512
+    int tile = 64;              // 分块 Floyd-Warshall 的块边长（节点数）
+    int threads = 1;            // 并行线程数，0 表示使用全部硬件线程
+    int sa_candidates = 32;     // 退火候选目标数 K，0 表示在全部节点中均匀抽取
+    long long seed = -1;        // 退火随机种子，小于 0 时按当前时间取种子
+    double time_limit = 1.8;    // 优化器的墙钟时间预算（秒）
+    long long sa_iterations = 0;    // 大于 0 时每条链运行固定的迭代次数，忽略时间预算
+    long long target_cost = -1;     // 不小于 0 时，最优总成本达到该值即提前结束
+    string optimizer = "sa";    // 分配优化器: sa（模拟退火）/ pt（并行回火）
+    int pt_replicas = 8;        // 并行回火的副本数
+    int sa_islands = 1;         // 并行退火的岛屿数，0 表示每个线程一个
+    string sa_moves = "compound";   // 退火移动类型: relocate / compound（目标已满时尝试交换与逐出链）
+    string sim_policy = "index";    // 链路放行顺序: index / longest-path / largest-demand / earliest-deadline
+    string sa_schedule = "adaptive";    // 降温策略: fixed（固定初温与系数）/ adaptive（标定初温、按接受率调整）
+    bool sa_stats = false;      // 结束时向标准错误输出退火统计与收敛轨迹
+    string apsp_cache;          // 最短路表缓存目录，为空时不使用缓存
+    string link_updates;        // 规划完成后依次应用的链路变更文件
+    string input;               // 输入文件路径（文本或二进制快照），为空时读取标准输入
+    string convert_binary;      // 非空时把输入转换为二进制快照写到该路径后退出
+    string bench;               // 非空时只运行指定的基准测试: apsp / parse
+    int bench_nodes = 1000;     // 基准测试随机拓扑的节点数
+    int bench_tasks = 1000000;  // 基准测试随机生成的任务数
+};
+Options opt;
 
 // 日志结构
 struct LogEntry {
@@ -65,73 +253,873 @@ int total_time_steps = 0;       // 记录完成所有迁移所需的总时间步
 // 初始化与输入
 
 void init() {
-    // 初始化 dist 矩阵、邻接矩阵、路由表
+    // 按节点数分配并初始化 dist 矩阵、邻接矩阵、路由表
+    // 填充区与第 0 行/列保持 INF，任何经过它们的松弛都不会生效
+    nodes.assign(N + 1, Node{0, 0, 0});
+    dist.assign(N, INF);
+    adj_bandwidth.assign(N, 0);
+    next_hop.assign(N, 0);
+    links.clear();
     for (int i = 1; i <= N; ++i) {
+        dist[i][i] = 0;
         for (int j = 1; j <= N; ++j) {
-            if (i == j) {
-                dist[i][j] = 0;
-            } else {
-                dist[i][j] = INF;
-            }
-            adj_bandwidth[i][j] = 0;
             next_hop[i][j] = j; // 默认下一跳为目标节点本身
         }
     }
 }
 
-void readInput() {
-    // 读取 N, M, T、读取节点信息、读取链路信息、读取任务信息
-    if (!(cin >> N >> M >> T)) return;
+// 登记一条无向链路
+void addLink(int u, int v, int c, int b) {
+    links.push_back({u, v, c, b});
+    adj_bandwidth[u][v] = adj_bandwidth[v][u] = b;
+    // 初始化距离矩阵：如果输入多条边，保留成本最小的一条
+    if (c < dist[u][v]) {
+        dist[u][v] = dist[v][u] = c;
+    }
+}
+
+// 输入缓冲区
+// 常规文件直接 mmap 映射为只读内存，不做任何拷贝；管道、终端等无法映射的输入
+// 退化为按大块 read() 读入一段连续内存。两种情况下解析器看到的都是 [data, data + size)。
+class InputBuffer {
+public:
+    ~InputBuffer() {
+        if (mapped_) munmap(mapped_, size_);
+    }
+
+    // 打开输入，fd 由调用方负责关闭
+    bool open(int fd) {
+        struct stat st;
+        if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+            void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                madvise(p, st.st_size, MADV_SEQUENTIAL);
+                mapped_ = p;
+                size_ = st.st_size;
+                data_ = static_cast<const char*>(p);
+                return true;
+            }
+        }
+        const size_t CHUNK = 1 << 20;
+        for (;;) {
+            size_t old = owned_.size();
+            owned_.resize(old + CHUNK);
+            ssize_t got = read(fd, &owned_[old], CHUNK);
+            if (got < 0) return false;
+            owned_.resize(old + got);
+            if (got == 0) break;
+        }
+        data_ = owned_.data();
+        size_ = owned_.size();
+        return true;
+    }
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    void* mapped_ = nullptr;
+    vector<char> owned_;
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+// 整数扫描器：在一段内存上逐个解析十进制整数，同时统计行号用于报错
+class IntScanner {
+public:
+    IntScanner(const char* begin, const char* end) : p_(begin), end_(end) {}
+
+    // 读取下一个整数；到达末尾、遇到非法字符或超出 int 范围时返回 false
+    bool next(int& out) {
+        if (atEnd()) return false;
+        bool neg = (*p_ == '-');
+        if (neg) ++p_;
+        const char* digits = p_;
+        long long v = 0;
+        while (p_ < end_ && (unsigned)(*p_ - '0') < 10) {
+            v = v * 10 + (*p_ - '0');
+            if (v > (long long)INT_MAX + 1) return false;
+            ++p_;
+        }
+        if (p_ == digits) return false;
+        if (p_ < end_ && !isspace((unsigned char)*p_)) return false;    // 数字后紧跟其他字符
+        v = neg ? -v : v;
+        if (v > INT_MAX || v < INT_MIN) return false;
+        out = (int)v;
+        return true;
+    }
+
+    // 跳过空白后是否已到达末尾，用于区分正常结束与非法输入
+    bool atEnd() {
+        while (p_ < end_ && (*p_ == ' ' || *p_ == '\n' || *p_ == '\t' || *p_ == '\r')) {
+            if (*p_ == '\n') ++line_;
+            ++p_;
+        }
+        return p_ == end_;
+    }
+
+    int line() const { return line_; }
+
+private:
+    const char* p_;
+    const char* end_;
+    int line_ = 1;
+};
+
+// 基于 istream 的读取器，与 IntScanner 接口相同；行号不可知，仅供基准测试对比
+class StreamReader {
+public:
+    explicit StreamReader(istream& in) : in_(in) {}
+    bool next(int& out) { return (bool)(in_ >> out); }
+    int line() const { return 0; }
+
+private:
+    istream& in_;
+};
+
+// 报告解析错误：line 为 0 时表示行号不可知
+static void inputError(int line, const string& msg) {
+    if (line > 0) cerr << "line " << line << ": ";
+    cerr << msg << endl;
+}
+
+// 读取一组整数，失败时报告出错位置
+template <class Reader>
+static bool readFields(Reader& in, int* out, int count, const char* what, int index) {
+    for (int k = 0; k < count; ++k) {
+        if (!in.next(out[k])) {
+            inputError(in.line(), string("expected integer in ") + what + " #" + to_string(index + 1));
+            return false;
+        }
+    }
+    return true;
+}
+
+// 校验节点编号范围，越界时报告出错位置
+template <class Reader>
+static bool checkNodeId(Reader& in, int id, const char* what, int index) {
+    if (id >= 1 && id <= N) return true;
+    inputError(in.line(), string("invalid ") + what + " #" + to_string(index + 1) + ": node id " +
+               to_string(id) + " out of range [1, " + to_string(N) + "]");
+    return false;
+}
+
+// 读取 N, M, T、读取节点信息、读取链路信息、读取任务信息
+template <class Reader>
+bool parseInput(Reader& in) {
+    int header[3];
+    if (!readFields(in, header, 3, "header", 0)) return false;
+    N = header[0];
+    M = header[1];
+    T = header[2];
+    if (N <= 0 || M < 0 || T < 0) {
+        inputError(in.line(), "invalid header: N=" + to_string(N) + " M=" + to_string(M) +
+                   " T=" + to_string(T));
+        return false;
+    }
     
     init();
 
     // 读取节点信息
     for (int i = 0; i < N; ++i) {
-        int id, cap;
-        cin >> id >> cap;
-        nodes[id].id = id;
-        nodes[id].capacity = cap;
-        nodes[id].current_usage = 0;
+        int f[2];   // id, cap
+        if (!readFields(in, f, 2, "node", i)) return false;
+        if (!checkNodeId(in, f[0], "node", i)) return false;
+        nodes[f[0]].id = f[0];
+        nodes[f[0]].capacity = f[1];
+        nodes[f[0]].current_usage = 0;
     }
 
     // 读取链路信息
+    links.reserve(M);
     for (int i = 0; i < M; ++i) {
-        int u, v, c, b;
-        cin >> u >> v >> c >> b;
-        adj_bandwidth[u][v] = adj_bandwidth[v][u] = b;
-        // 初始化距离矩阵：如果输入多条边，保留成本最小的一条
-        if (c < dist[u][v]) {
-            dist[u][v] = dist[v][u] = c;    
-        }
+        int f[4];   // u, v, c, b
+        if (!readFields(in, f, 4, "link", i)) return false;
+        if (!checkNodeId(in, f[0], "link", i) || !checkNodeId(in, f[1], "link", i)) return false;
+        addLink(f[0], f[1], f[2], f[3]);
     }
 
     // 读取任务信息
+    tasks.clear();
+    tasks.reserve(T);
+    for (int i = 0; i < T; ++i) {
+        int f[3];   // tid, s_node, dem
+        if (!readFields(in, f, 3, "task", i)) return false;
+        if (!checkNodeId(in, f[1], "task", i)) return false;
+        tasks.push_back({f[0], f[1], f[2], f[1], 0, {}, {}, 0, f[1], false});
+    }
+    return true;
+}
+
+// 二进制快照格式
+// 文件由 64 字节的头部和若干按 64 字节对齐的 int32 数组组成，依次为：
+//   节点容量 capacity[N]（下标 i 对应节点 i + 1）
+//   链路 u[M]、v[M]、cost[M]、bandwidth[M]
+//   任务 id[T]、start_node[T]、demand[T]
+// 数组按本机字节序存放，头部的 byte_order 用于识别不匹配的文件。
+// 加载时整个文件被 mmap 映射，数组直接在映射内存上读取，不做任何文本解析。
+// 文本输入可用 --convert-binary=FILE 转换为该格式；--input 读取时按魔数自动识别。
+const char SNAPSHOT_MAGIC[8] = {'C', 'L', 'B', 'O', 'S', 'N', 'A', 'P'};
+const uint32_t SNAPSHOT_VERSION = 1;
+const uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304;
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    int32_t n, m, t;
+    uint32_t reserved[9];
+};
+static_assert(sizeof(SnapshotHeader) == 64, "snapshot header must be 64 bytes");
+
+// 各数组在文件中的偏移量，最后一项为文件总长度
+struct SnapshotLayout {
+    enum { CAPACITY, LINK_U, LINK_V, LINK_COST, LINK_BW, TASK_ID, TASK_START, TASK_DEMAND, END };
+    size_t offset[END + 1];
+
+    SnapshotLayout(long long n, long long m, long long t) {
+        const long long count[END] = {n, m, m, m, m, t, t, t};
+        size_t pos = sizeof(SnapshotHeader);
+        for (int k = 0; k < END; ++k) {
+            offset[k] = pos;
+            pos += (size_t)count[k] * sizeof(int32_t);
+            pos = (pos + 63) / 64 * 64;
+        }
+        offset[END] = pos;
+    }
+};
+
+static bool isSnapshot(const char* data, size_t size) {
+    return size >= sizeof(SnapshotHeader) && memcmp(data, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) == 0;
+}
+
+// 将当前的节点、链路、任务编码为快照
+void encodeSnapshot(vector<char>& out) {
+    SnapshotLayout layout(N, (long long)links.size(), (long long)tasks.size());
+    out.assign(layout.offset[SnapshotLayout::END], 0);
+
+    SnapshotHeader header = {};
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.byte_order = SNAPSHOT_BYTE_ORDER;
+    header.n = N;
+    header.m = (int32_t)links.size();
+    header.t = (int32_t)tasks.size();
+    memcpy(out.data(), &header, sizeof(header));
+
+    auto section = [&](int k) { return reinterpret_cast<int32_t*>(out.data() + layout.offset[k]); };
+    int32_t* cap = section(SnapshotLayout::CAPACITY);
+    for (int i = 1; i <= N; ++i) cap[i - 1] = nodes[i].capacity;
+    int32_t* lu = section(SnapshotLayout::LINK_U);
+    int32_t* lv = section(SnapshotLayout::LINK_V);
+    int32_t* lc = section(SnapshotLayout::LINK_COST);
+    int32_t* lb = section(SnapshotLayout::LINK_BW);
+    for (size_t i = 0; i < links.size(); ++i) {
+        lu[i] = links[i].u;
+        lv[i] = links[i].v;
+        lc[i] = links[i].cost;
+        lb[i] = links[i].bandwidth;
+    }
+    int32_t* tid = section(SnapshotLayout::TASK_ID);
+    int32_t* ts = section(SnapshotLayout::TASK_START);
+    int32_t* td = section(SnapshotLayout::TASK_DEMAND);
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        tid[i] = tasks[i].id;
+        ts[i] = tasks[i].start_node;
+        td[i] = tasks[i].demand;
+    }
+}
+
+bool writeSnapshot(const string& path) {
+    vector<char> bytes;
+    encodeSnapshot(bytes);
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        cerr << "cannot create " << path << ": " << strerror(errno) << endl;
+        return false;
+    }
+    size_t done = 0;
+    while (done < bytes.size()) {
+        ssize_t n = write(fd, bytes.data() + done, bytes.size() - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        done += n;
+    }
+    close(fd);
+    if (done != bytes.size()) {
+        cerr << "cannot write " << path << ": " << strerror(errno) << endl;
+        return false;
+    }
+    return true;
+}
+
+// 从映射内存加载快照，校验头部与长度后直接读取各数组
+bool loadSnapshot(const char* data, size_t size) {
+    SnapshotHeader header;
+    memcpy(&header, data, sizeof(header));
+    if (header.byte_order != SNAPSHOT_BYTE_ORDER || header.version != SNAPSHOT_VERSION) {
+        cerr << "snapshot: unsupported version " << header.version << " or byte order" << endl;
+        return false;
+    }
+    if (header.n <= 0 || header.m < 0 || header.t < 0) {
+        cerr << "snapshot: invalid header: N=" << header.n << " M=" << header.m << " T=" << header.t << endl;
+        return false;
+    }
+    SnapshotLayout layout(header.n, header.m, header.t);
+    if (size < layout.offset[SnapshotLayout::END]) {
+        cerr << "snapshot: truncated file (" << size << " of " << layout.offset[SnapshotLayout::END]
+             << " bytes)" << endl;
+        return false;
+    }
+    N = header.n;
+    M = header.m;
+    T = header.t;
+    init();
+
+    auto section = [&](int k) { return reinterpret_cast<const int32_t*>(data + layout.offset[k]); };
+    const int32_t* cap = section(SnapshotLayout::CAPACITY);
+    for (int i = 1; i <= N; ++i) nodes[i] = {i, cap[i - 1], 0};
+
+    const int32_t* lu = section(SnapshotLayout::LINK_U);
+    const int32_t* lv = section(SnapshotLayout::LINK_V);
+    const int32_t* lc = section(SnapshotLayout::LINK_COST);
+    const int32_t* lb = section(SnapshotLayout::LINK_BW);
+    links.reserve(M);
+    for (int i = 0; i < M; ++i) {
+        if (lu[i] < 1 || lu[i] > N || lv[i] < 1 || lv[i] > N) {
+            cerr << "snapshot: invalid link #" << i + 1 << ": node id out of range [1, " << N << "]" << endl;
+            return false;
+        }
+        addLink(lu[i], lv[i], lc[i], lb[i]);
+    }
+
+    const int32_t* tid = section(SnapshotLayout::TASK_ID);
+    const int32_t* ts = section(SnapshotLayout::TASK_START);
+    const int32_t* td = section(SnapshotLayout::TASK_DEMAND);
+    tasks.clear();
+    tasks.resize(T);
     for (int i = 0; i < T; ++i) {
-        int tid, s_node, dem;
-        cin >> tid >> s_node >> dem;
-        tasks.push_back({tid, s_node, dem, s_node, 0, {}, 0, s_node, false});
+        if (ts[i] < 1 || ts[i] > N) {
+            cerr << "snapshot: invalid task #" << i + 1 << ": node id out of range [1, " << N << "]" << endl;
+            return false;
+        }
+        Task& t = tasks[i];
+        t.id = tid[i];
+        t.start_node = t.end_node = t.current_pos_node = ts[i];
+        t.demand = td[i];
+        t.migration_cost = 0;
+        t.path_idx = 0;
+        t.finished = false;
+    }
+    return true;
+}
+
+// 从 --input 指定的文件（默认标准输入）读取全部数据，文本与二进制快照按魔数自动识别
+bool readInput() {
+    int fd = 0;
+    if (!opt.input.empty()) {
+        fd = ::open(opt.input.c_str(), O_RDONLY);
+        if (fd < 0) {
+            cerr << "cannot open " << opt.input << ": " << strerror(errno) << endl;
+            return false;
+        }
+    }
+    InputBuffer buf;
+    bool ok = buf.open(fd);
+    if (fd != 0) close(fd);
+    if (!ok) {
+        cerr << "cannot read input: " << strerror(errno) << endl;
+        return false;
+    }
+    if (isSnapshot(buf.data(), buf.size())) return loadSnapshot(buf.data(), buf.size());
+    IntScanner in(buf.data(), buf.data() + buf.size());
+    return parseInput(in);
+}
+
+// 最小加（min-plus）行松弛内核
+// 对 j in [0, len): 若 dik + dk[j] < di[j]，则 di[j] = dik + dk[j]，ni[j] = nik。
+// 依靠 INF 的饱和语义（见 INF 定义）省去不可达判断，循环内没有分支，
+// 各指令集版本用比较掩码 + 混合（blend）一次更新 dist 与 next_hop。
+typedef void (*MinPlusKernel)(int* di, int* ni, const int* dk, int dik, int nik, int len);
+
+static void minPlusRowScalar(int* di, int* ni, const int* dk, int dik, int nik, int len) {
+    for (int j = 0; j < len; ++j) {
+        int cand = dik + dk[j];
+        bool better = cand < di[j];
+        di[j] = better ? cand : di[j];
+        ni[j] = better ? nik : ni[j];
+    }
+}
+
+#ifdef HAVE_X86_SIMD
+__attribute__((target("avx2")))
+static void minPlusRowAvx2(int* di, int* ni, const int* dk, int dik, int nik, int len) {
+    const __m256i vdik = _mm256_set1_epi32(dik);
+    const __m256i vnik = _mm256_set1_epi32(nik);
+    int j = 0;
+    for (; j + 8 <= len; j += 8) {
+        __m256i cand = _mm256_add_epi32(vdik, _mm256_loadu_si256((const __m256i*)(dk + j)));
+        __m256i cur = _mm256_loadu_si256((const __m256i*)(di + j));
+        __m256i better = _mm256_cmpgt_epi32(cur, cand);
+        __m256i hop = _mm256_loadu_si256((const __m256i*)(ni + j));
+        _mm256_storeu_si256((__m256i*)(di + j), _mm256_min_epi32(cur, cand));
+        _mm256_storeu_si256((__m256i*)(ni + j), _mm256_blendv_epi8(hop, vnik, better));
+    }
+    minPlusRowScalar(di + j, ni + j, dk + j, dik, nik, len - j);
+}
+
+__attribute__((target("avx512f")))
+static void minPlusRowAvx512(int* di, int* ni, const int* dk, int dik, int nik, int len) {
+    const __m512i vdik = _mm512_set1_epi32(dik);
+    const __m512i vnik = _mm512_set1_epi32(nik);
+    int j = 0;
+    for (; j + 16 <= len; j += 16) {
+        __m512i cand = _mm512_add_epi32(vdik, _mm512_loadu_si512(dk + j));
+        __mmask16 better = _mm512_cmplt_epi32_mask(cand, _mm512_loadu_si512(di + j));
+        _mm512_mask_storeu_epi32(di + j, better, cand);
+        _mm512_mask_storeu_epi32(ni + j, better, vnik);
+    }
+    if (j < len) {
+        // 尾部用掩码处理，不回落到标量
+        __mmask16 tail = (__mmask16)((1u << (len - j)) - 1);
+        __m512i cand = _mm512_add_epi32(vdik, _mm512_maskz_loadu_epi32(tail, dk + j));
+        __mmask16 better = _mm512_mask_cmplt_epi32_mask(tail, cand, _mm512_maskz_loadu_epi32(tail, di + j));
+        _mm512_mask_storeu_epi32(di + j, better, cand);
+        _mm512_mask_storeu_epi32(ni + j, better, vnik);
+    }
+}
+#endif
+
+MinPlusKernel minPlusRow = minPlusRowScalar;
+const char* minPlusKernelName = "scalar";
+
+// 按 CPU 特性选择内核；want 为 auto 时取可用的最宽指令集。
+// 请求的指令集不被支持时返回 false，保持原内核不变。
+bool selectMinPlusKernel(const string& want) {
+#ifdef HAVE_X86_SIMD
+    __builtin_cpu_init();
+    bool has512 = __builtin_cpu_supports("avx512f");
+    bool has2 = __builtin_cpu_supports("avx2");
+    if ((want == "auto" || want == "avx512") && has512) {
+        minPlusRow = minPlusRowAvx512;
+        minPlusKernelName = "avx512";
+        return true;
+    }
+    if ((want == "auto" || want == "avx2") && has2) {
+        minPlusRow = minPlusRowAvx2;
+        minPlusKernelName = "avx2";
+        return true;
+    }
+#endif
+    if (want == "auto" || want == "scalar") {
+        minPlusRow = minPlusRowScalar;
+        minPlusKernelName = "scalar";
+        return true;
     }
+    return false;
 }
 
 // Floyd-Warshall 最短路径
 // 三重循环遍历所有节点，计算出任意两点间迁移任务的最小单位成本。
 // 同时，next_hop 记录路径重构所需的信息（要从 i 去 j，应该先去 next_hop[i][j]）。
+// 内层 j 循环交给 min-plus 内核，按填充后的整行处理：行首对齐且无尾部，
+// 第 0 列与填充列恒为 INF，不会被更新。
+// 第 k 轮中第 k 行与第 k 列都不会改变（dist[k][k] = 0），各行之间没有依赖，
+// 因此每一轮的行可以分给线程池并行处理，结果与串行逐项相同。
 void floydWarshall() {
+    const int width = dist.stride();
     // k: 中转节点，i: 起点，j: 终点
     for (int k = 1; k <= N; ++k) {
-        for (int i = 1; i <= N; ++i) {
-            for (int j = 1; j <= N; ++j) {
-                // 检查 i->k 和 k->j 是否连通
-                if (dist[i][k] != INF && dist[k][j] != INF) {
-                    // 如果经过 k 中转的总距离小于当前已知距离
-                    if (dist[i][k] + dist[k][j] < dist[i][j]) {
-                        dist[i][j] = dist[i][k] + dist[k][j];   
-                        next_hop[i][j] = next_hop[i][k];       
-                    }
+        const int* dk = dist[k];
+        pool.parallelFor(1, N + 1, [&](int lo, int hi) {
+            for (int i = lo; i < hi; ++i) {
+                // i->k 不连通时整行都不可能被更新；第 k 行本身无需处理
+                int dik = dist[i][k];
+                if (dik == INF || i == k) continue;
+                minPlusRow(dist[i], next_hop[i], dk, dik, next_hop[i][k], width);
+            }
+        });
+    }
+}
+
+// 分块 Floyd-Warshall
+// 将节点划分为 tile x tile 的块，每一轮以第 kb 个对角块为中转集合：
+// 1. 先在对角块内部完成松弛（后两步都依赖它的结果）；
+// 2. 再更新与对角块同行、同列的面板块；
+// 3. 最后更新其余所有块，它们只依赖第 1、2 步的结果。
+// 每一步的工作集只有三个块，块足够小时可常驻 L1/L2，避免整行扫描反复失效。
+// 得到的 dist 与经典三重循环完全一致；路径等长时 next_hop 可能选中另一条同样最短的路径。
+// 第 2、3 步内各块只写自身、只读对角块或面板块，按块分给线程池并行，结果与串行分块版本相同。
+static void relaxBlock(int i0, int i1, int j0, int j1, int k0, int k1) {
+    for (int k = k0; k < k1; ++k) {
+        const int* dk = dist[k];
+        for (int i = i0; i < i1; ++i) {
+            int dik = dist[i][k];
+            if (dik == INF) continue;
+            minPlusRow(dist[i] + j0, next_hop[i] + j0, dk + j0, dik, next_hop[i][k], j1 - j0);
+        }
+    }
+}
+
+void floydWarshallBlocked(int tile) {
+    if (tile < 1) tile = 1;
+    const int lo = 1, hi = N + 1;   // 有效节点区间 [1, N]
+    const int blocks = (N + tile - 1) / tile;
+    for (int k0 = lo; k0 < hi; k0 += tile) {
+        int k1 = min(k0 + tile, hi);
+
+        // 第 1 步：对角块
+        relaxBlock(k0, k1, k0, k1, k0, k1);
+
+        // 第 2 步：同行面板与同列面板（偶数编号为行面板，奇数为列面板）
+        pool.parallelFor(0, 2 * blocks, [&](int lo_task, int hi_task) {
+            for (int task = lo_task; task < hi_task; ++task) {
+                int b0 = lo + (task / 2) * tile;
+                if (b0 == k0) continue;
+                int b1 = min(b0 + tile, hi);
+                if (task % 2 == 0) {
+                    relaxBlock(k0, k1, b0, b1, k0, k1);
+                } else {
+                    relaxBlock(b0, b1, k0, k1, k0, k1);
+                }
+            }
+        }, 1);
+
+        // 第 3 步：其余块，按块行并行
+        pool.parallelFor(0, blocks, [&](int lo_row, int hi_row) {
+            for (int row = lo_row; row < hi_row; ++row) {
+                int i0 = lo + row * tile;
+                if (i0 == k0) continue;
+                int i1 = min(i0 + tile, hi);
+                for (int j0 = lo; j0 < hi; j0 += tile) {
+                    if (j0 == k0) continue;
+                    relaxBlock(i0, i1, j0, min(j0 + tile, hi), k0, k1);
                 }
             }
+        }, 1);
+    }
+}
+
+// 压缩稀疏行（CSR）邻接表
+// 节点 u 的邻居位于 adj[offset[u] .. offset[u+1])，无向边在两个端点各存一份，
+// 与稠密矩阵相比只占 O(N + M) 内存，遍历邻居时连续访问。
+struct CsrGraph {
+    vector<int> offset;     // 长度 N + 2，下标为节点编号
+    vector<int> adj;        // 邻居节点
+    vector<int> cost;       // 对应边的成本
+
+    void build(int n, const vector<Link>& edges) {
+        offset.assign(n + 2, 0);
+        for (const auto& e : edges) {
+            offset[e.u + 1]++;
+            offset[e.v + 1]++;
+        }
+        for (int i = 1; i <= n + 1; ++i) offset[i] += offset[i - 1];
+        adj.resize(offset[n + 1]);
+        cost.resize(offset[n + 1]);
+        vector<int> fill(offset.begin(), offset.end() - 1);
+        for (const auto& e : edges) {
+            adj[fill[e.u]] = e.v;
+            cost[fill[e.u]++] = e.cost;
+            adj[fill[e.v]] = e.u;
+            cost[fill[e.v]++] = e.cost;
+        }
+    }
+};
+CsrGraph csr;
+
+// 单源 Dijkstra（二叉堆），距离写入 d[1..N]
+// first 非空时记录从 src 出发的第一跳，parent 非空时记录最短路树上的前驱；
+// 不可达节点的距离为 INF，第一跳保持默认值（目标节点本身），与 Floyd-Warshall 的约定一致。
+// heap 由调用方提供以便在同一线程内复用内存。
+typedef pair<long long, int> HeapItem;     // (距离, 节点)
+
+void dijkstraFrom(int src, int* d, int* first, int* parent, vector<HeapItem>& heap) {
+    for (int v = 1; v <= N; ++v) {
+        d[v] = INF;
+        if (first) first[v] = v;
+        if (parent) parent[v] = v;
+    }
+    d[src] = 0;
+
+    auto cmp = greater<HeapItem>();
+    heap.clear();
+    heap.push_back({0, src});
+    while (!heap.empty()) {
+        pop_heap(heap.begin(), heap.end(), cmp);
+        HeapItem top = heap.back();
+        heap.pop_back();
+        int u = top.second;
+        if (top.first != d[u]) continue;    // 过期的堆元素
+        for (int e = csr.offset[u]; e < csr.offset[u + 1]; ++e) {
+            int v = csr.adj[e];
+            int nd = d[u] + csr.cost[e];
+            if (nd < d[v]) {
+                d[v] = nd;
+                if (first) first[v] = (u == src) ? v : first[u];
+                if (parent) parent[v] = u;
+                heap.push_back({nd, v});
+                push_heap(heap.begin(), heap.end(), cmp);
+            }
+        }
+    }
+}
+
+// 对 sources 中的每个源点计算 dist / next_hop 整行，源点之间互不依赖，分给线程池并行。
+void dijkstraRows(const vector<int>& sources) {
+    pool.parallelFor(0, (int)sources.size(), [&](int lo, int hi) {
+        vector<HeapItem> heap;
+        for (int i = lo; i < hi; ++i) {
+            int src = sources[i];
+            dijkstraFrom(src, dist[src], next_hop[src], nullptr, heap);
+        }
+    });
+}
+
+// 稀疏图全源最短路：从每个源点各跑一次 Dijkstra。
+// 总复杂度 O(N * M log N)，M 远小于 N^2 时明显快于 O(N^3)。
+// dist 与 Floyd-Warshall 完全一致；存在多条等长最短路时 next_hop 可能选中其中另一条。
+void dijkstraAllPairs() {
+    csr.build(N, links);
+    vector<int> sources(N);
+    for (int i = 0; i < N; ++i) sources[i] = i + 1;
+    dijkstraRows(sources);
+}
+
+// 按需最短路（lazy 引擎）
+// 分配阶段（贪心、退火、总成本）只读取 dist[start_node][*]，因此只对任务中出现过的
+// 不同起点计算整行。迁移模拟还需要路径上各中间节点指向终点的 next_hop，
+// 这部分推迟到终点确定后，由 ensureRoutes() 对每个用到的终点 e 求一棵最短路树：
+// 图是无向的，树上 v 的前驱就是 v 走向 e 的下一跳，即 next_hop[v][e]。
+// 任务集中在少数热点节点时，预计算量从 N 次单源搜索降到“起点数 + 终点数”次。
+// 在该模式下，非起点行的 dist 与非终点列的 next_hop 均未计算，不能读取。
+bool routes_pending = false;    // lazy 引擎尚未为终点补全 next_hop
+bool tables_partial = false;    // 当前的表由 lazy 引擎算出，只有部分行有效
+
+// 任务中出现的不同起点（升序）
+vector<int> distinctTaskSources() {
+    vector<char> seen(N + 1, 0);
+    vector<int> sources;
+    for (const auto& t : tasks) {
+        if (!seen[t.start_node]) {
+            seen[t.start_node] = 1;
+            sources.push_back(t.start_node);
+        }
+    }
+    sort(sources.begin(), sources.end());
+    return sources;
+}
+
+void lazySourceRows() {
+    csr.build(N, links);
+    dijkstraRows(distinctTaskSources());
+    routes_pending = true;
+    tables_partial = true;
+}
+
+// 为所有需要迁移的任务的终点补全 next_hop 列（反向最短路树）
+void ensureRoutes() {
+    if (!routes_pending) return;
+    vector<char> seen(N + 1, 0);
+    vector<int> targets;
+    for (const auto& t : tasks) {
+        if (t.start_node != t.end_node && !seen[t.end_node]) {
+            seen[t.end_node] = 1;
+            targets.push_back(t.end_node);
+        }
+    }
+    pool.parallelFor(0, (int)targets.size(), [&](int lo, int hi) {
+        vector<HeapItem> heap;
+        vector<int> d(N + 1), parent(N + 1);
+        for (int i = lo; i < hi; ++i) {
+            int e = targets[i];
+            dijkstraFrom(e, d.data(), nullptr, parent.data(), heap);
+            for (int v = 1; v <= N; ++v) next_hop[v][e] = parent[v];
+        }
+    });
+    routes_pending = false;
+}
+
+// 最短路表的磁盘缓存
+// 拓扑的变化远少于任务分布，因此把 dist / next_hop 连同拓扑哈希保存到 --apsp-cache 目录，
+// 下次运行若哈希一致就直接 mmap 映射文件复用，跳过整个最短路计算阶段。
+// 哈希覆盖决定这两张表的全部输入：N 以及每条链路的 (u, v, cost)，按输入顺序计入；
+// 节点容量与带宽不影响最短路，改动它们仍可命中缓存。
+// 各引擎（以及分块引擎的不同块大小）对等长最短路的取舍不同，next_hop 会不同，
+// 因此引擎与块大小同样计入哈希并写入头部，不一致时视为未命中，不会把一个引擎的路由交给另一个。
+// 文件布局：64 字节头部，随后是 dist 与 next_hop 两个矩阵的原始内存（含填充，均 64 字节对齐）。
+// 映射使用 MAP_PRIVATE，之后对表的修改只发生在进程私有的副本上，不会写回文件。
+// lazy 引擎只算出部分表，既不读取也不写入缓存。
+const char APSP_CACHE_MAGIC[8] = {'C', 'L', 'B', 'O', 'A', 'P', 'S', 'P'};
+const uint32_t APSP_CACHE_VERSION = 2;
+
+struct ApspCacheHeader {
+    char magic[8];
+    uint32_t version;
+    int32_t n;
+    int32_t stride;
+    int32_t engine;         // apspEngineId()
+    uint64_t topology_hash;
+    int32_t tile;           // 分块引擎的块大小，其他引擎为 0
+    uint32_t reserved[7];
+};
+static_assert(sizeof(ApspCacheHeader) == 64, "cache header must be 64 bytes");
+
+// 64 位 FNV-1a
+static void fnv1a(uint64_t& h, int32_t v) {
+    for (int k = 0; k < 4; ++k) {
+        h ^= (uint32_t)v >> (8 * k) & 0xff;
+        h *= 1099511628211ULL;
+    }
+}
+
+// 写入缓存的引擎编号：classic 1、blocked 2、dijkstra 3
+static int32_t apspEngineId(const string& engine) {
+    if (engine == "blocked") return 2;
+    if (engine == "dijkstra") return 3;
+    return 1;
+}
+
+static int32_t apspEngineTile(const string& engine) {
+    return engine == "blocked" ? opt.tile : 0;
+}
+
+uint64_t topologyHash(const string& engine) {
+    uint64_t h = 14695981039346656037ULL;
+    fnv1a(h, apspEngineId(engine));
+    fnv1a(h, apspEngineTile(engine));
+    fnv1a(h, N);
+    fnv1a(h, (int32_t)links.size());
+    for (const auto& e : links) {
+        fnv1a(h, e.u);
+        fnv1a(h, e.v);
+        fnv1a(h, e.cost);
+    }
+    return h;
+}
+
+static string apspCachePath(uint64_t hash) {
+    char name[32];
+    snprintf(name, sizeof(name), "apsp-%016llx.bin", (unsigned long long)hash);
+    return opt.apsp_cache + "/" + name;
+}
+
+// 命中时把 dist / next_hop 切换为映射内存并返回 true
+bool loadApspCache(uint64_t hash, const string& engine) {
+    string path = apspCachePath(hash);
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    ApspCacheHeader header;
+    size_t matrix_bytes = (size_t)(N + 1) * dist.stride() * sizeof(int);
+    bool ok = fstat(fd, &st) == 0 && (size_t)st.st_size == sizeof(header) + 2 * matrix_bytes &&
+              pread(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header) &&
+              memcmp(header.magic, APSP_CACHE_MAGIC, sizeof(header.magic)) == 0 &&
+              header.version == APSP_CACHE_VERSION && header.n == N &&
+              header.stride == dist.stride() && header.topology_hash == hash &&
+              header.engine == apspEngineId(engine) && header.tile == apspEngineTile(engine);
+    void* p = ok ? mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    close(fd);
+    if (p == MAP_FAILED) {
+        if (ok) cerr << "apsp cache: cannot map " << path << ": " << strerror(errno) << endl;
+        return false;
+    }
+    size_t length = st.st_size;
+    shared_ptr<void> mapping(p, [length](void* q) { munmap(q, length); });
+    char* base = static_cast<char*>(p) + sizeof(header);
+    dist.adopt(N, shared_ptr<int>(mapping, reinterpret_cast<int*>(base)));
+    next_hop.adopt(N, shared_ptr<int>(mapping, reinterpret_cast<int*>(base + matrix_bytes)));
+    return true;
+}
+
+// 先写临时文件再改名，避免并发运行读到写了一半的缓存
+void saveApspCache(uint64_t hash, const string& engine) {
+    string path = apspCachePath(hash);
+    string tmp = path + ".tmp." + to_string(getpid());
+    int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        cerr << "apsp cache: cannot create " << tmp << ": " << strerror(errno) << endl;
+        return;
+    }
+    ApspCacheHeader header = {};
+    memcpy(header.magic, APSP_CACHE_MAGIC, sizeof(header.magic));
+    header.version = APSP_CACHE_VERSION;
+    header.n = N;
+    header.stride = dist.stride();
+    header.engine = apspEngineId(engine);
+    header.topology_hash = hash;
+    header.tile = apspEngineTile(engine);
+    size_t matrix_bytes = (size_t)(N + 1) * dist.stride() * sizeof(int);
+    const char* parts[3] = {reinterpret_cast<const char*>(&header),
+                            reinterpret_cast<const char*>(dist[0]),
+                            reinterpret_cast<const char*>(next_hop[0])};
+    const size_t sizes[3] = {sizeof(header), matrix_bytes, matrix_bytes};
+    bool ok = true;
+    for (int k = 0; k < 3 && ok; ++k) {
+        size_t done = 0;
+        while (done < sizes[k]) {
+            ssize_t n = write(fd, parts[k] + done, sizes[k] - done);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) {
+                ok = false;
+                break;
+            }
+            done += n;
+        }
+    }
+    close(fd);
+    if (!ok || rename(tmp.c_str(), path.c_str()) != 0) {
+        cerr << "apsp cache: cannot write " << path << ": " << strerror(errno) << endl;
+        unlink(tmp.c_str());
+    }
+}
+
+// 按参数选择最短路引擎
+// auto 模式下小规模图沿用经典三重循环；节点较多时按粗略的工作量模型在三者中取最小：
+//   分块 Floyd-Warshall   N^3 / 16（16 路向量化）
+//   全源 Dijkstra          N * (2M + N) * log2(N)
+//   按需 Dijkstra          约 2S 次单源搜索（S 个起点，终点数按同量级估计）
+// 两类操作的实测单次开销相近（N = 2500、M = 4N 时约 3 ns），故直接比较。
+// 启用磁盘缓存时，先确定引擎再尝试复用该引擎写入的缓存；auto 模式下不选 lazy，以便算出完整的表写入缓存。
+void computeShortestPaths() {
+    const int BLOCKED_MIN_NODES = 256;
+    routes_pending = false;
+    tables_partial = false;
+
+    string engine = opt.apsp;
+    if (engine == "auto") {
+        if (N < BLOCKED_MIN_NODES) {
+            engine = "classic";
+        } else {
+            double per_search = (2.0 * M + N) * log2((double)N);
+            double fw = (double)N * N * N / 16;
+            double full = N * per_search;
+            double lazy = 2.0 * distinctTaskSources().size() * per_search;
+            if (lazy < full && lazy < fw && opt.apsp_cache.empty()) {
+                engine = "lazy";
+            } else {
+                engine = (full < fw) ? "dijkstra" : "blocked";
+            }
         }
     }
+
+    if (engine == "lazy") {
+        lazySourceRows();
+        return;
+    }
+    uint64_t hash = 0;
+    if (!opt.apsp_cache.empty()) {
+        hash = topologyHash(engine);
+        if (loadApspCache(hash, engine)) return;
+    }
+    if (engine == "dijkstra") {
+        dijkstraAllPairs();
+    } else if (engine == "blocked") {
+        floydWarshallBlocked(opt.tile);
+    } else {
+        floydWarshall();
+    }
+    if (!opt.apsp_cache.empty()) saveApspCache(hash, engine);
 }
 
 // 贪心分配，生成初始解
@@ -189,92 +1177,1018 @@ long long calculateTotalCost() {
     return total;
 }
 
-void optimizeAllocationSA() {
-    srand(time(NULL));
-
-    // 初始温度参数
-    double T_start = 2000.0;    // 初始温度
-    double T_end = 1e-8;         // 终止温度
-    double cooling_rate = 0.999;    // 降温系数
+// 伪随机数生成器：xoshiro256**
+// 每条退火链持有自己的实例，没有全局状态与锁；64 位种子经 splitmix64 展开为 256 位状态，
+// 同一种子总得到同一序列。below(n) 用 Lemire 的乘法取高位方法在 [0, n) 内无偏抽样，
+// 只在极少数情况下需要一次取模来拒绝，避免了 rand() % n 的除法与低位质量问题。
+class Rng {
+public:
+    explicit Rng(uint64_t seed) {
+        for (auto& w : s_) {
+            seed += 0x9e3779b97f4a7c15ULL;
+            uint64_t z = seed;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            w = z ^ (z >> 31);
+        }
+    }
 
-    double current_temp = T_start;
-    long long current_cost = calculateTotalCost();   // 当前总成本
+    uint64_t next() {
+        uint64_t result = rotl(s_[1] * 5, 7) * 9;
+        uint64_t t = s_[1] << 17;
+        s_[2] ^= s_[0];
+        s_[3] ^= s_[1];
+        s_[1] ^= s_[2];
+        s_[0] ^= s_[3];
+        s_[2] ^= t;
+        s_[3] = rotl(s_[3], 45);
+        return result;
+    }
 
-    // 记录全局最优
-    long long best_cost = current_cost;
-    vector<int> best_assignment(T);
-    for(int i=0; i<T; ++i) best_assignment[i] = tasks[i].end_node;
+    // [0, n) 内的均匀整数，n > 0
+    uint32_t below(uint32_t n) {
+        uint64_t m = (next() >> 32) * n;
+        if ((uint32_t)m < n) {
+            uint32_t threshold = -n % n;
+            while ((uint32_t)m < threshold) m = (next() >> 32) * n;
+        }
+        return (uint32_t)(m >> 32);
+    }
 
-    // 使用时钟控制
-    double time_limit = 1.8; 
-    clock_t start_clock = clock();
+    // [0, 1) 内的均匀实数（53 位精度）
+    double uniform() { return (next() >> 11) * 0x1.0p-53; }
 
-    int iter = 0;
-    while (true) {
-        // 每 1024 次检查一次时间
-        if ((iter & 1023) == 0) {
-            double elapsed = (double)(clock() - start_clock) / CLOCKS_PER_SEC;
-            if (elapsed > time_limit) break;
-        }
-        iter++;
+private:
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
 
-        int t_idx = rand() % T;
-        Task& t = tasks[t_idx];
-        int old_node = t.end_node;
-        int new_node = (rand() % N) + 1;
+    uint64_t s_[4];
+};
 
-        if (new_node == old_node || dist[t.start_node][new_node] == INF) continue;
+// 由 --seed 决定的退火种子；未指定时按当前时间取种子，每次运行不同
+uint64_t annealSeed() {
+    if (opt.seed >= 0) return (uint64_t)opt.seed;
+    return (uint64_t)chrono::system_clock::now().time_since_epoch().count();
+}
 
-        if (nodes[new_node].current_usage + t.demand <= nodes[new_node].capacity) {
-            long long cost_diff = ((long long)dist[t.start_node][new_node] * t.demand) - 
-                                  ((long long)dist[t.start_node][old_node] * t.demand);
+// 退火问题数据（结构数组布局，所有退火链共享，只读）
+// 内层循环只访问下面几个连续数组，不再随机跳读 Task 对象与 dist 的各行：
+// 任务 i 放到节点 v 的成本为 row[i][v] * scale[i]，当前成本缓存在各链的 cost[i]，
+// 一次移动的增量只需各取一次新、旧两侧。
+// (起点, 需求) 组合的种类数不超过 N 时，为每种组合预先算好一整行成本，row 指向该行、scale 为 1；
+// 否则成本表会比 dist 更大，随机访问时缓存失效反而更慢，此时 row 直接指向 dist 的起点行、
+// scale 为需求。某个乘积不小于 INF（存不进 int，或会被当成不可达）时同样退回后者，
+// 成本由内层循环按 long long 相乘。两种行里不可达都记为 INF。
+// 候选列表：K > 0 时，每个起点保留成本最低的 K 个可达目标（含起点本身，按距离升序），
+// 任务 i 的候选为 cand[i][0 .. ncand[i])，提议只从中抽取，避免在大规模集群上把绝大多数
+// 迭代浪费在不可达或成本明显过高的节点上。K = 0 时退回到在全部节点中均匀抽取。
+struct SaProblem {
+    vector<const int*> row;
+    vector<int> scale;
+    vector<int> demand;
+    vector<int> table;      // 预计算的成本行，每行 N + 1 个元素
+    vector<const int*> cand;
+    vector<int> ncand;
+    vector<int> cand_pool;  // 各起点的候选列表，每个起点 K 个位置
 
-            if (cost_diff < 0 || exp(-cost_diff / current_temp) > ((double)rand() / RAND_MAX)) {
-                nodes[old_node].current_usage -= t.demand;
-                nodes[new_node].current_usage += t.demand;
-                t.end_node = new_node;
-                t.migration_cost = dist[t.start_node][new_node] * t.demand;
-                current_cost += cost_diff;
+    void build(int k) {
+        row.resize(T);
+        scale.resize(T);
+        demand.resize(T);
 
-                if (current_cost < best_cost) {
-                    best_cost = current_cost;
-                    for(int k=0; k<T; ++k) best_assignment[k] = tasks[k].end_node;
+        unordered_map<long long, int> classes;
+        vector<int> cls(T);
+        for (int i = 0; i < T; ++i) {
+            const Task& t = tasks[i];
+            long long key = (long long)t.start_node << 32 | (uint32_t)t.demand;
+            cls[i] = classes.emplace(key, (int)classes.size()).first->second;
+        }
+        const size_t width = N + 1;
+        bool use_table = (int)classes.size() <= N;
+        if (use_table) {
+            table.assign(classes.size() * width, INF);
+            for (const auto& c : classes) {
+                int start = (int)(c.first >> 32), dem = (int)(uint32_t)c.first;
+                int* r = &table[c.second * width];
+                for (int v = 1; v <= N && use_table; ++v) {
+                    if (dist[start][v] == INF) continue;
+                    long long cost = (long long)dist[start][v] * dem;
+                    // 乘积须小于 INF 才能存为 int 且不与不可达混淆，否则退回 dist 行 × scale
+                    if (cost >= INF) use_table = false;
+                    r[v] = (int)cost;
                 }
+                if (!use_table) break;
             }
+            if (!use_table) vector<int>().swap(table);
+        }
+        for (int i = 0; i < T; ++i) {
+            const Task& t = tasks[i];
+            row[i] = use_table ? &table[cls[i] * width] : dist[t.start_node];
+            scale[i] = use_table ? 1 : t.demand;
+            demand[i] = t.demand;
         }
+        if (k > 0) buildCandidates(min(k, N));
+    }
 
-        // 动态降温策略
-        current_temp *= cooling_rate;
-        // 如果温度过低，重置温度，继续利用剩余时间搜索
-        if (current_temp < T_end) {
-            current_temp = T_start * 0.5; 
+    void buildCandidates(int k) {
+        vector<int> slot(N + 1, -1), starts;
+        for (const auto& t : tasks) {
+            if (slot[t.start_node] < 0) {
+                slot[t.start_node] = (int)starts.size();
+                starts.push_back(t.start_node);
+            }
+        }
+        cand_pool.assign(starts.size() * k, 0);
+        vector<int> count(starts.size());
+        pool.parallelFor(0, (int)starts.size(), [&](int lo, int hi) {
+            vector<int> order;
+            for (int j = lo; j < hi; ++j) {
+                const int* d = dist[starts[j]];
+                order.clear();
+                for (int v = 1; v <= N; ++v) {
+                    if (d[v] != INF) order.push_back(v);
+                }
+                auto by_dist = [d](int a, int b) { return d[a] < d[b] || (d[a] == d[b] && a < b); };
+                int m = min(k, (int)order.size());
+                partial_sort(order.begin(), order.begin() + m, order.end(), by_dist);
+                copy(order.begin(), order.begin() + m, cand_pool.begin() + (size_t)j * k);
+                count[j] = m;
+            }
+        });
+        cand.resize(T);
+        ncand.resize(T);
+        for (int i = 0; i < T; ++i) {
+            int j = slot[tasks[i].start_node];
+            cand[i] = &cand_pool[(size_t)j * k];
+            ncand[i] = count[j];
         }
     }
 
-    // 恢复最优解
-    for(int i=1; i<=N; ++i) nodes[i].current_usage = 0;
-    for(int i=0; i<T; ++i) {
-        tasks[i].end_node = best_assignment[i];
-        tasks[i].migration_cost = dist[tasks[i].start_node][tasks[i].end_node] * tasks[i].demand;
-        nodes[tasks[i].end_node].current_usage += tasks[i].demand;
+    // 为任务 i 提议一个目标节点
+    int propose(int i, Rng& rng) const {
+        return cand.empty() ? (int)rng.below(N) + 1 : cand[i][rng.below(ncand[i])];
     }
-}
+};
+
+// 退火的当前解（每条链各持一份）
+// room[v] 为节点 v 的剩余容量，total 为当前总成本。
+// members[v] 为当前位于节点 v 的任务，slot[i] 为任务 i 在其中的位置，移动时 O(1) 维护，
+// 供复合移动从已满节点中随机挑选要逐出的任务。
+const int SA_MAX_CHAIN = 3;     // 复合移动最多包含的任务数
+
+struct SaChainStep {
+    int task, to;
+    long long cost;     // 移动后该任务的成本
+};
+
+struct SaState {
+    const SaProblem* p = nullptr;
+    vector<int> end;
+    vector<long long> cost;
+    vector<int> room;
+    vector<vector<int>> members;
+    vector<int> slot;
+    long long total = 0;
+
+    // 以 assignment（各任务的目标节点）为当前解，O(T + N)
+    void assign(const SaProblem& prob, const vector<int>& assignment) {
+        p = &prob;
+        end = assignment;
+        cost.resize(T);
+        // 剩余容量按全部任务的当前位置计算（贪心未能安置的任务留在起点，同样占用容量）
+        room.assign(N + 1, 0);
+        for (int v = 1; v <= N; ++v) room[v] = nodes[v].capacity;
+        members.assign(N + 1, {});
+        slot.resize(T);
+        total = 0;
+        for (int i = 0; i < T; ++i) {
+            cost[i] = (long long)p->row[i][end[i]] * p->scale[i];
+            total += cost[i];
+            room[end[i]] -= p->demand[i];
+            slot[i] = (int)members[end[i]].size();
+            members[end[i]].push_back(i);
+        }
+    }
+
+    // 把任务 i 移到节点 to，新成本为 new_cost
+    void move(int i, int to, long long new_cost) {
+        int from = end[i];
+        vector<int>& src = members[from];
+        int last = src.back();
+        src[slot[i]] = last;
+        slot[last] = slot[i];
+        src.pop_back();
+        slot[i] = (int)members[to].size();
+        members[to].push_back(i);
+        room[from] += p->demand[i];
+        room[to] -= p->demand[i];
+        end[i] = to;
+        total += new_cost - cost[i];
+        cost[i] = new_cost;
+    }
+
+    // 逐出链：任务 a 要移到容量不足的节点 v 时，从 v 上随机逐出一个足以腾出空间的任务 b，
+    // b 以一半概率换回 a 的原节点（即两任务交换），否则移到它自己的一个候选目标；
+    // 若 b 的目标同样容量不足，则继续从该节点逐出，链长至多 SA_MAX_CHAIN。
+    // 可行时 chain 记录各步、diff 为成本增量，整条链只有 O(链长) 的计算量。
+    bool buildChain(int a, int v, long long a_cost, vector<SaChainStep>& chain, long long& diff, Rng& rng) const {
+        const vector<int>& demand = p->demand;
+        chain.clear();
+        chain.push_back({a, v, a_cost});
+        diff = a_cost - cost[a];
+        int at = v;
+        int deficit = demand[a] - room[v];
+        while ((int)chain.size() < SA_MAX_CHAIN) {
+            const vector<int>& m = members[at];
+            if (m.empty()) return false;
+            int b = m[rng.below((uint32_t)m.size())];
+            if (demand[b] < deficit) return false;
+            for (const auto& st : chain) {
+                if (st.task == b) return false;
+            }
+            int w = (rng.next() >> 63) ? end[a] : p->propose(b, rng);
+            if (w == at || p->row[b][w] == INF) return false;
+            long long b_cost = (long long)p->row[b][w] * p->scale[b];
+            chain.push_back({b, w, b_cost});
+            diff += b_cost - cost[b];
+            // 整条链执行后 w 的剩余容量
+            int free_w = room[w];
+            for (const auto& st : chain) {
+                if (end[st.task] == w) free_w += demand[st.task];
+                if (st.to == w) free_w -= demand[st.task];
+            }
+            if (free_w >= 0) return true;
+            deficit = -free_w;
+            at = w;
+        }
+        return false;
+    }
+};
+
+// 退火运行统计
+struct SaStats {
+    long long iterations = 0;   // 尝试的移动数
+    long long accepted = 0;     // 被接受的移动数
+    long long compound = 0;     // 其中交换与逐出链的个数
+    long long improvements = 0; // 刷新最优解的次数
+    long long uphill_proposed = 0;  // 可行的上坡提议数
+    long long uphill_accepted = 0;  // 其中被接受的个数
+    double initial_temp = 0;        // 初温（自适应时为标定结果）
+    long long migrations = 0;   // 岛屿模型中最优解迁入其他岛屿的次数
+    long long exchange_attempts = 0;    // 并行回火中尝试的副本交换次数
+    long long exchanges = 0;            // 其中被接受的次数
+
+    void add(const SaStats& o) {
+        iterations += o.iterations;
+        accepted += o.accepted;
+        compound += o.compound;
+        improvements += o.improvements;
+        uphill_proposed += o.uphill_proposed;
+        uphill_accepted += o.uphill_accepted;
+        migrations += o.migrations;
+        exchange_attempts += o.exchange_attempts;
+        exchanges += o.exchanges;
+    }
+};
+
+// 优化器的终止条件
+// 默认按 steady_clock 计量墙钟时间（--time-limit），与进程 CPU 时间无关，多线程时同样准确。
+// 指定 --sa-iterations 时改为每条链固定的迭代次数，不再读时钟决定何时停止，配合 --seed 可完全复现；
+// --target-cost 使任一条链的最优成本不高于目标时提前结束。
+struct SaBudget {
+    chrono::steady_clock::time_point start;
+    chrono::steady_clock::time_point deadline;
+    long long iterations;   // 每条链的迭代上限
+    long long target;       // 目标成本，LLONG_MIN 表示不设
+
+    explicit SaBudget(double time_limit) {
+        start = chrono::steady_clock::now();
+        if (opt.sa_iterations > 0) {
+            deadline = chrono::steady_clock::time_point::max();
+            iterations = opt.sa_iterations;
+        } else {
+            deadline = start +
+                       chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(time_limit));
+            iterations = LLONG_MAX;
+        }
+        target = opt.target_cost >= 0 ? opt.target_cost : LLONG_MIN;
+    }
+
+    bool timed() const { return iterations == LLONG_MAX; }
+
+    // 已用去的预算比例 [0, 1]：按时间或按一条链已完成的迭代数
+    double progress(long long done, chrono::steady_clock::time_point now) const {
+        double f = timed() ? chrono::duration<double>(now - start).count() /
+                             max(1e-9, chrono::duration<double>(deadline - start).count())
+                           : (double)done / iterations;
+        return min(1.0, max(0.0, f));
+    }
+};
+
+// 自适应降温
+// 初温由采样标定：随机抽取若干可行的上坡移动（与退火使用相同的候选提议），
+// 取其平均增量 d，使 exp(-d / T0) = SA_ACCEPT_START；固定的 2000 对小增量的实例相当于
+// 随机游走，对大增量的实例又几乎立即冻结，标定后与实例的成本尺度无关。
+// 运行中每 SA_ADAPT_WINDOW 次上坡提议统计一次接受率，与随预算进度从 SA_ACCEPT_START
+// 几何下降到 SA_ACCEPT_END 的目标比较，按 (期望接受数 + 1) / (实际接受数 + 1) 的平方根
+// 调整温度（单次调整限制在 [1/2, 2] 倍），使接受率跟随目标曲线，收敛速度与预算长度匹配。
+const double SA_ACCEPT_START = 0.5;
+const double SA_ACCEPT_END = 1e-3;
+const int SA_ADAPT_WINDOW = 1000;
+const int SA_CALIBRATION_SAMPLES = 2000;
+
+// 采样得到的可行上坡移动的成本增量
+struct UphillSample {
+    double mean = 0;        // 平均增量，找不到上坡移动时为 0
+    long long min = 0;      // 最小增量
+};
+
+static UphillSample sampleUphillDeltas(const SaState& s, Rng& rng) {
+    const SaProblem& p = *s.p;
+    UphillSample r;
+    double sum = 0;
+    int found = 0;
+    for (int attempt = 0; attempt < 50 * SA_CALIBRATION_SAMPLES && found < SA_CALIBRATION_SAMPLES; ++attempt) {
+        int i = (int)rng.below(T);
+        int v = p.propose(i, rng);
+        if (v == s.end[i] || p.row[i][v] == INF || s.room[v] < p.demand[i]) continue;
+        long long d = (long long)p.row[i][v] * p.scale[i] - s.cost[i];
+        if (d <= 0) continue;
+        sum += d;
+        r.min = found ? min(r.min, d) : d;
+        ++found;
+    }
+    if (found) r.mean = sum / found;
+    return r;
+}
+
+// 接受率为 accept 时增量 delta 对应的温度
+static double temperatureFor(double delta, double accept) {
+    return -delta / log(accept);
+}
+
+// 收敛过程的采样点
+struct SaTraceSample {
+    double progress;
+    double temp;
+    double accept;      // 自上一个采样点以来上坡移动的接受率
+    long long cost;     // 当前成本
+    long long best;
+};
+
+// 一条退火链：当前解、历史最优解、温度与独立的随机数生成器
+// 固定的降温策略：从 SA_T_START 按 SA_COOLING 逐次降温，低于 SA_T_END 时回升到初温的一半，
+// 继续利用剩余时间搜索；cooling 为 1 时温度保持不变（并行回火的各副本）。
+// adaptive 为 true 时改用上面的自适应降温，此时需要设置 budget 以计算进度。
+// run() 可多次调用，温度与最优解在调用之间保留。
+// Metropolis 接受测试：exp(-d / T) > u 等价于 d < T * E，其中 E = -ln(u) 服从指数分布。
+// E 由 refillThresholds() 每次批量生成 SA_THRESHOLD_BATCH 个，内层循环只需一次乘法与比较，
+// 不再有除法与 exp()。u 取自 (0, 1] 上的 53 位均匀数，E 不超过 SA_THRESHOLD_MAX，
+// 因此 d >= T * SA_THRESHOLD_MAX 时必然拒绝，可以直接跳过、不消耗阈值，接受概率分布不变。
+// 最优解惰性记录：best 只保存某个基准时刻的解，之后每次被接受的移动按 (任务, 目标) 追加到
+// journal；刷新最优时只把 best_mark 移到日志末尾，最优解即 best 依次重放 journal[0, best_mark)。
+// 日志长度超过 max(T, SA_JOURNAL_MIN) 时把这段前缀并入 best 并清空日志，此后的移动不再记录，
+// 直到下一次刷新最优时整体拷贝一次当前解（O(T)，但至少间隔 T 次移动）。
+// 因此每次刷新最优的摊还代价为 O(1)，而不是每次都拷贝 T 个元素。
+const double SA_T_START = 2000.0;   // 初始温度
+const double SA_T_END = 1e-8;       // 终止温度
+const double SA_COOLING = 0.999;    // 降温系数
+const size_t SA_JOURNAL_MIN = 4096;
+const double SA_CHECK_PERIOD = 1e-3;   // 两次检查时间的目标间隔（秒）
+const long long SA_CHECK_MIN = 256;
+const long long SA_CHECK_MAX = 1 << 22;
+const int SA_TRACE_POINTS = 10;
+const int SA_THRESHOLD_BATCH = 256;
+const double SA_THRESHOLD_MAX = 53 * 0.6931471805599453;   // -ln(2^-53)
+
+struct SaChain {
+    SaState s;
+    Rng rng;
+    double temp = SA_T_START;
+    double cooling = SA_COOLING;
+    bool adaptive = false;
+    const SaBudget* budget = nullptr;
+    long long target = LLONG_MIN;   // 目标成本，最优成本不高于它时停止
+    long long best_cost = 0;
+    SaStats stats;
+    vector<SaChainStep> chain;
+    vector<SaTraceSample> trace;    // 每完成 1/SA_TRACE_POINTS 的预算记录一次
+
+    SaChain(const SaProblem& prob, const vector<int>& assignment, uint64_t seed) : rng(seed) {
+        s.assign(prob, assignment);
+        best = s.end;
+        best_cost = s.total;
+        chain.reserve(SA_MAX_CHAIN);
+    }
+
+    // 历史最优解（把日志中属于最优解的前缀并入 best）
+    const vector<int>& bestAssignment() {
+        foldJournal();
+        return best;
+    }
+
+    // 以 assignment 整体替换当前解（岛屿迁移），已记录的最优解不变
+    void reset(const vector<int>& assignment) {
+        foldJournal();
+        s.assign(*s.p, assignment);
+        journal.clear();
+        journal_off = true;
+    }
+
+    // 运行到 until、满 max_iters 次迭代或最优成本不高于 target 为止。
+    // 时间按批检查：每批迭代数按上一批的实测速度调整，使两次读时钟相隔约 SA_CHECK_PERIOD 秒，
+    // 既不在内层循环里逐次计数取模，也不会因为移动开销差异很大而错过截止时间。
+    void run(chrono::steady_clock::time_point until, bool compound, long long max_iters = LLONG_MAX) {
+        long long done = 0;
+        auto now = chrono::steady_clock::now();
+        while (done < max_iters && best_cost > target && now < until) {
+            if (budget) {
+                double f = budget->progress(stats.iterations + done, now);
+                if (f >= (double)trace.size() / SA_TRACE_POINTS) sample(f);
+            }
+            steps_base = stats.iterations + done;
+            long long n = min(check_batch, max_iters - done);
+            long long ran = steps(n, compound);
+            done += ran;
+            auto later = chrono::steady_clock::now();
+            if (ran == check_batch) {
+                double elapsed = max(1e-9, chrono::duration<double>(later - now).count());
+                long long want = (long long)(ran * (SA_CHECK_PERIOD / elapsed));
+                check_batch = max(SA_CHECK_MIN, min({want, 2 * ran, SA_CHECK_MAX}));
+            }
+            now = later;
+        }
+        stats.iterations += done;
+    }
+
+    // 执行至多 n 次迭代，最优成本达到 target 时提前返回，返回实际迭代次数
+    long long steps(long long n, bool compound) {
+        const SaProblem& p = *s.p;
+        for (long long iter = 0; iter < n; ++iter) {
+            int i = (int)rng.below(T);
+            int old_node = s.end[i];
+            int new_node = p.propose(i, rng);
+            int c = p.row[i][new_node];
+
+            if (new_node == old_node || c == INF) continue;
+
+            long long new_cost = (long long)c * p.scale[i];
+            long long cost_diff = 0;
+            bool feasible = true;
+            chain.clear();
+            if (s.room[new_node] >= p.demand[i]) {
+                cost_diff = new_cost - s.cost[i];
+            } else {
+                // 容量不足：单任务迁移不可行，尝试交换或逐出链
+                feasible = compound && s.buildChain(i, new_node, new_cost, chain, cost_diff, rng);
+            }
+
+            bool uphill = feasible && cost_diff > 0;
+            if (uphill) {
+                ++stats.uphill_proposed;
+                ++window_proposed;
+            }
+            if (feasible && (cost_diff < 0 || (cost_diff < temp * SA_THRESHOLD_MAX && cost_diff < temp * threshold()))) {
+                if (uphill) {
+                    ++stats.uphill_accepted;
+                    ++window_accepted;
+                }
+                if (chain.empty()) {
+                    s.move(i, new_node, new_cost);
+                    record(i, new_node);
+                } else {
+                    for (const auto& st : chain) {
+                        s.move(st.task, st.to, st.cost);
+                        record(st.task, st.to);
+                    }
+                    ++stats.compound;
+                }
+                ++stats.accepted;
+
+                if (s.total < best_cost) {
+                    best_cost = s.total;
+                    markBest();
+                    ++stats.improvements;
+                    if (best_cost <= target) return iter + 1;
+                }
+            }
+
+            if (adaptive) {
+                if (window_proposed == SA_ADAPT_WINDOW) adapt(steps_base + iter);
+                continue;
+            }
+            // 动态降温策略
+            temp *= cooling;
+            // 如果温度过低，重置温度，继续利用剩余时间搜索
+            if (temp < SA_T_END) {
+                temp = SA_T_START * 0.5;
+            }
+        }
+        return n;
+    }
+
+    // 记录一个采样点
+    void sample(double progress) {
+        long long proposed = stats.uphill_proposed - trace_proposed;
+        long long accepted = stats.uphill_accepted - trace_accepted;
+        trace.push_back({progress, temp, proposed ? (double)accepted / proposed : 0.0, s.total, best_cost});
+        trace_proposed = stats.uphill_proposed;
+        trace_accepted = stats.uphill_accepted;
+    }
+
+private:
+    long long steps_base = 0;   // 本批开始前的累计迭代数
+    int window_proposed = 0, window_accepted = 0;
+    long long trace_proposed = 0, trace_accepted = 0;
+    long long check_batch = SA_CHECK_MIN;
+
+    // 按最近一个窗口的接受率调整温度，done 为累计迭代数。
+    // 目标接受率在窗口边界上按进度计算（而不是在按时间划分的批次边界上），按迭代次数终止时结果可复现。
+    void adapt(long long done) {
+        double f = budget ? budget->progress(done, budget->timed() ? chrono::steady_clock::now()
+                                                                    : chrono::steady_clock::time_point())
+                          : 0.0;
+        double accept_target = SA_ACCEPT_START * pow(SA_ACCEPT_END / SA_ACCEPT_START, f);
+        double factor = sqrt((accept_target * window_proposed + 1) / (window_accepted + 1.0));
+        temp *= min(2.0, max(0.5, factor));
+        window_proposed = window_accepted = 0;
+    }
+
+    double thresholds[SA_THRESHOLD_BATCH];
+    int threshold_pos = SA_THRESHOLD_BATCH;
+
+    // 下一个 -ln(u)
+    double threshold() {
+        if (threshold_pos == SA_THRESHOLD_BATCH) refillThresholds();
+        return thresholds[threshold_pos++];
+    }
+
+    void refillThresholds() {
+        for (int k = 0; k < SA_THRESHOLD_BATCH; ++k) {
+            thresholds[k] = -log(((rng.next() >> 11) + 1) * 0x1.0p-53);
+        }
+        threshold_pos = 0;
+    }
+
+    vector<int> best;
+    vector<pair<int, int>> journal;     // 基准时刻之后被接受的移动 (任务, 目标节点)
+    size_t best_mark = 0;               // 最优解对应的日志长度
+    bool journal_off = false;           // 日志已溢出，当前解不能由 best 重放得到
+
+    void record(int task, int to) {
+        if (journal_off) return;
+        journal.push_back({task, to});
+        if (journal.size() > max((size_t)T, SA_JOURNAL_MIN)) {
+            foldJournal();
+            journal.clear();
+            journal_off = true;
+        }
+    }
+
+    void markBest() {
+        if (journal_off) {
+            best = s.end;
+            journal.clear();
+            journal_off = false;
+        }
+        best_mark = journal.size();
+    }
+
+    void foldJournal() {
+        for (size_t k = 0; k < best_mark; ++k) best[journal[k].first] = journal[k].second;
+        journal.erase(journal.begin(), journal.begin() + best_mark);
+        best_mark = 0;
+    }
+};
+
+// 退火统计与最优链的收敛轨迹，写到标准错误，不影响标准输出的结果
+static void reportSa(const char* name, const SaStats& stats, const SaChain& c) {
+    cerr << fixed << setprecision(4) << name << ": iterations " << stats.iterations << "  accepted "
+         << 100.0 * stats.accepted / max(1LL, stats.iterations) << "%  uphill accepted "
+         << 100.0 * stats.uphill_accepted / max(1LL, stats.uphill_proposed) << "%  improvements "
+         << stats.improvements << "  T0 " << c.stats.initial_temp << "  T " << c.temp << endl;
+    cerr << "  progress        temp   uphill acc        cost        best" << endl;
+    for (const auto& t : c.trace) {
+        cerr << setw(10) << t.progress << setw(12) << t.temp << setw(12) << t.accept << setw(12) << t.cost
+             << setw(12) << t.best << endl;
+    }
+}
+
+// 恢复最优解：把各任务的目标节点写回 tasks，并重新统计迁移成本与节点负载
+static void commitAssignment(const vector<int>& best_assignment) {
+    for(int i=1; i<=N; ++i) nodes[i].current_usage = 0;
+    for(int i=0; i<T; ++i) {
+        tasks[i].end_node = best_assignment[i];
+        tasks[i].migration_cost = dist[tasks[i].start_node][tasks[i].end_node] * tasks[i].demand;
+        nodes[tasks[i].end_node].current_usage += tasks[i].demand;
+    }
+}
+
+// 模拟退火主流程
+// 岛屿数为 1 时只运行一条链。多于 1 时各岛屿从同一初解出发、使用不同的随机种子，
+// 在线程池上并行运行；每隔 SA_MIGRATION_INTERVAL 秒（按迭代次数终止时为每条链
+// SA_MIGRATION_STEPS 次迭代）同步一次，把全局最优解复制给当前成本最高的岛屿，
+// 最后返回所有岛屿中的最优解。岛屿数多于线程数时，每个同步周期的时间按轮次平分，
+// 总耗时仍不超过 time_limit。
+const double SA_MIGRATION_INTERVAL = 0.1;
+const long long SA_MIGRATION_STEPS = 1 << 20;
+
+// 任一条链达到目标成本，或所有链都用完迭代次数
+static bool budgetSpent(const vector<unique_ptr<SaChain>>& chains, const SaBudget& budget) {
+    bool spent = true;
+    for (const auto& c : chains) {
+        if (c->best_cost <= budget.target) return true;
+        spent = spent && c->stats.iterations >= budget.iterations;
+    }
+    return spent;
+}
+
+SaStats optimizeAllocationSA(double time_limit) {
+    SaStats stats;
+    if (T == 0) return stats;
+
+    SaProblem prob;
+    prob.build(opt.sa_candidates);
+    const bool compound = (opt.sa_moves == "compound");
+    vector<int> initial(T);
+    for (int i = 0; i < T; ++i) initial[i] = tasks[i].end_node;
+
+    int islands = opt.sa_islands > 0 ? opt.sa_islands : pool.size();
+    uint64_t seed = annealSeed();
+    SaBudget budget(time_limit);
+    vector<unique_ptr<SaChain>> chains(islands);
+    const bool adaptive = (opt.sa_schedule == "adaptive");
+    pool.parallelFor(0, islands, [&](int lo, int hi) {
+        for (int k = lo; k < hi; ++k) {
+            SaChain& c = *(chains[k] = unique_ptr<SaChain>(new SaChain(prob, initial, seed + k)));
+            c.target = budget.target;
+            c.budget = &budget;
+            if (adaptive) {
+                double mean = sampleUphillDeltas(c.s, c.rng).mean;
+                c.adaptive = mean > 0;
+                if (c.adaptive) c.temp = temperatureFor(mean, SA_ACCEPT_START);
+            }
+            c.stats.initial_temp = c.temp;
+        }
+    }, 1);
+
+    if (islands == 1) {
+        chains[0]->run(budget.deadline, compound, budget.iterations);
+    } else {
+        const int rounds = (islands + pool.size() - 1) / pool.size();
+        for (auto now = chrono::steady_clock::now(); now < budget.deadline && !budgetSpent(chains, budget);
+             now = chrono::steady_clock::now()) {
+            auto epoch_end = budget.deadline;
+            auto slice = chrono::steady_clock::duration::max();
+            if (budget.timed()) {
+                epoch_end = min(budget.deadline, now + chrono::duration_cast<chrono::steady_clock::duration>(
+                                                            chrono::duration<double>(SA_MIGRATION_INTERVAL)));
+                slice = (epoch_end - now) / rounds;
+            }
+            pool.parallelFor(0, islands, [&](int lo, int hi) {
+                for (int k = lo; k < hi; ++k) {
+                    SaChain& c = *chains[k];
+                    auto until = budget.timed() ? min(epoch_end, chrono::steady_clock::now() + slice) : epoch_end;
+                    c.run(until, compound, min(SA_MIGRATION_STEPS, budget.iterations - c.stats.iterations));
+                }
+            }, 1);
+
+            // 迁移：全局最优解替换当前成本最高的岛屿
+            int best = 0, worst = 0;
+            for (int k = 1; k < islands; ++k) {
+                if (chains[k]->best_cost < chains[best]->best_cost) best = k;
+                if (chains[k]->s.total > chains[worst]->s.total) worst = k;
+            }
+            if (worst != best) {
+                chains[worst]->reset(chains[best]->bestAssignment());
+                ++stats.migrations;
+            }
+        }
+    }
+
+    int best = 0;
+    for (int k = 0; k < islands; ++k) {
+        stats.add(chains[k]->stats);
+        if (chains[k]->best_cost < chains[best]->best_cost) best = k;
+    }
+    stats.initial_temp = chains[best]->stats.initial_temp;
+    if (opt.sa_stats) {
+        chains[best]->sample(budget.progress(chains[best]->stats.iterations, chrono::steady_clock::now()));
+        reportSa("sa", stats, *chains[best]);
+    }
+    commitAssignment(chains[best]->bestAssignment());
+    return stats;
+}
+
+// 并行回火（副本交换）
+// R 个副本各自在固定温度下运行 Metropolis 链，温度从 PT_T_MIN 到 SA_T_START 按几何级数排成阶梯。
+// 每个副本走 PT_EXCHANGE_STEPS 步后同步一次，相邻温度的副本 a（较冷）、b（较热）以概率
+// min(1, exp((1/T_a - 1/T_b) * (E_a - E_b))) 交换构型；交换只需互换两者的温度并更新阶梯顺序，
+// 不拷贝解。奇偶轮交替尝试偶数对与奇数对，使构型能在整条阶梯上游走：
+// 高温副本负责跨越能垒，好的构型逐级下沉到低温副本精细搜索，无需再对整个解反复升温。
+// 各副本在线程池上并行运行，输入输出与 optimizeAllocationSA() 相同，返回所有副本见过的最优解。
+const double PT_T_MIN = 1.0;
+const int PT_EXCHANGE_STEPS = 4096;
+
+SaStats optimizeAllocationPT(double time_limit) {
+    SaStats stats;
+    if (T == 0) return stats;
+
+    SaProblem prob;
+    prob.build(opt.sa_candidates);
+    const bool compound = (opt.sa_moves == "compound");
+    vector<int> initial(T);
+    for (int i = 0; i < T; ++i) initial[i] = tasks[i].end_node;
+
+    const int replicas = max(2, opt.pt_replicas);
+    uint64_t seed = annealSeed();
+    SaBudget budget(time_limit);
+    vector<unique_ptr<SaChain>> chains(replicas);
+    // 自适应模式下温度阶梯的两端由采样标定：最热一级以 SA_ACCEPT_START 的概率接受平均上坡移动，
+    // 最冷一级以 SA_ACCEPT_END 的概率接受最小的上坡移动。冷端若按平均增量标定，
+    // 小增量的上坡移动仍大量被接受，最冷的副本无法下降到贪心解以下。
+    double t_min = PT_T_MIN, t_max = SA_T_START;
+    if (opt.sa_schedule == "adaptive") {
+        SaState probe;
+        probe.assign(prob, initial);
+        Rng probe_rng(seed - 1);
+        UphillSample up = sampleUphillDeltas(probe, probe_rng);
+        if (up.mean > 0) {
+            t_min = temperatureFor((double)up.min, SA_ACCEPT_END);
+            t_max = temperatureFor(up.mean, SA_ACCEPT_START);
+        }
+    }
+    pool.parallelFor(0, replicas, [&](int lo, int hi) {
+        for (int k = lo; k < hi; ++k) {
+            chains[k].reset(new SaChain(prob, initial, seed + k));
+            chains[k]->target = budget.target;
+            chains[k]->temp = t_min * pow(t_max / t_min, (double)k / (replicas - 1));
+            chains[k]->stats.initial_temp = chains[k]->temp;
+            chains[k]->cooling = 1.0;
+            chains[k]->budget = &budget;
+        }
+    }, 1);
+    vector<int> ladder(replicas);   // ladder[r] 为第 r 级（由冷到热）上的副本
+    for (int r = 0; r < replicas; ++r) ladder[r] = r;
+    Rng rng(seed + replicas);
+
+    for (int round = 0; chrono::steady_clock::now() < budget.deadline && !budgetSpent(chains, budget); ++round) {
+        pool.parallelFor(0, replicas, [&](int lo, int hi) {
+            for (int k = lo; k < hi; ++k) {
+                SaChain& c = *chains[k];
+                c.run(budget.deadline, compound, min((long long)PT_EXCHANGE_STEPS, budget.iterations - c.stats.iterations));
+            }
+        }, 1);
+        for (int r = round & 1; r + 1 < replicas; r += 2) {
+            SaChain& a = *chains[ladder[r]];
+            SaChain& b = *chains[ladder[r + 1]];
+            double x = (1.0 / a.temp - 1.0 / b.temp) * (double)(a.s.total - b.s.total);
+            ++stats.exchange_attempts;
+            if (x >= 0 || exp(x) > rng.uniform()) {
+                swap(a.temp, b.temp);
+                swap(ladder[r], ladder[r + 1]);
+                ++stats.exchanges;
+            }
+        }
+    }
+
+    int best = 0;
+    for (int k = 0; k < replicas; ++k) {
+        stats.add(chains[k]->stats);
+        if (chains[k]->best_cost < chains[best]->best_cost) best = k;
+    }
+    stats.initial_temp = t_min;
+    if (opt.sa_stats) {
+        chains[best]->sample(budget.progress(chains[best]->stats.iterations, chrono::steady_clock::now()));
+        reportSa("pt", stats, *chains[best]);
+    }
+    commitAssignment(chains[best]->bestAssignment());
+    return stats;
+}
+
+// 链路变更与增量最短路
+// 链路在运行中会降级、恢复或中断。applyLinkUpdate() 把一次变更（新增、删除或修改 u-v 之间的链路）
+// 直接作用于现有的 dist / next_hop，只触及受影响的行，再只重新评估起点落在这些行上的任务。
+// 变更后 u-v 之间只保留这一条链路（删除时不保留），其有效成本从 w_old 变为 w_new：
+// - w_new < w_old（新增或降低成本）：d'[i][j] = min(d[i][j], d[i][u] + w + d[v][j], d[i][v] + w + d[u][j])。
+//   若某行有任何距离变短，该行到 v（或 u）的距离必然先变短，即 d[i][u] + w < d[i][v]，
+//   因此只需对满足该条件的行，用旧的第 v 行（或第 u 行）做一次 min-plus 行松弛，复用向量化内核。
+// - w_new > w_old（删除或提高成本）：只有最短路树经过该链路的源点 i 受影响，
+//   其充要条件为 d[i][u] + w_old == d[i][v] 或反之；这些行用新的邻接表重跑 Dijkstra。
+//   其余行的最短路均不经过该链路，距离不变，沿 next_hop 走出的路径仍是最短路。
+// 图是无向的，dist 对称，第 u 列即第 u 行。lazy 引擎只有部分行，变更后整体重算这些行。
+struct LinkUpdate {
+    int u, v;
+    int cost;           // 新成本，小于 0 表示删除 u-v 之间的链路
+    int bandwidth;
+};
+
+// u-v 之间当前的有效成本（多条链路取最小），没有链路时为 INF
+static int linkCost(int u, int v) {
+    int w = INF;
+    for (const auto& e : links) {
+        if ((e.u == u && e.v == v) || (e.u == v && e.v == u)) w = min(w, e.cost);
+    }
+    return w;
+}
+
+// 更新最短路表，返回每一行是否发生变化
+vector<char> updateShortestPaths(int u, int v, int w_old, int w_new) {
+    vector<char> changed(N + 1, 0);
+    if (w_new == w_old) return changed;
+    if (tables_partial) {
+        lazySourceRows();
+        for (int s : distinctTaskSources()) changed[s] = 1;
+        return changed;
+    }
+
+    // 旧的第 u、v 行（同时也是第 u、v 列）
+    vector<int> du(dist[u], dist[u] + dist.stride());
+    vector<int> dv(dist[v], dist[v] + dist.stride());
+
+    if (w_new < w_old) {
+        const int w = w_new;
+        const int width = dist.stride();
+        pool.parallelFor(1, N + 1, [&](int lo, int hi) {
+            for (int i = lo; i < hi; ++i) {
+                int a = du[i], b = dv[i];
+                if (a != INF && a + w < b) {
+                    minPlusRow(dist[i], next_hop[i], dv.data(), a + w, (i == u) ? v : next_hop[i][u], width);
+                    changed[i] = 1;
+                } else if (b != INF && b + w < a) {
+                    minPlusRow(dist[i], next_hop[i], du.data(), b + w, (i == v) ? u : next_hop[i][v], width);
+                    changed[i] = 1;
+                }
+            }
+        });
+        return changed;
+    }
+
+    vector<int> affected;
+    for (int i = 1; i <= N; ++i) {
+        int a = du[i], b = dv[i];
+        if (a == INF) continue;
+        if (a + w_old == b || b + w_old == a) {
+            affected.push_back(i);
+            changed[i] = 1;
+        }
+    }
+    dijkstraRows(affected);
+    return changed;
+}
+
+// 为任务重新选择可达且容量允许的最低成本节点，都不满足时留在起点
+static void reassignTask(Task& t) {
+    int best_node = t.start_node;
+    long long min_cost = -1;
+    for (int target = 1; target <= N; ++target) {
+        if (dist[t.start_node][target] == INF) continue;
+        if (nodes[target].current_usage + t.demand <= nodes[target].capacity) {
+            long long cost = (long long)dist[t.start_node][target] * t.demand;
+            if (min_cost < 0 || cost < min_cost) {
+                min_cost = cost;
+                best_node = target;
+            }
+        }
+    }
+    t.end_node = best_node;
+    nodes[best_node].current_usage += t.demand;
+}
+
+// 应用一次链路变更，返回迁移成本发生变化（或被重新分配）的任务数
+int applyLinkUpdate(const LinkUpdate& up) {
+    int u = up.u, v = up.v;
+    int w_old = linkCost(u, v);
+    links.erase(remove_if(links.begin(), links.end(), [&](const Link& e) {
+        return (e.u == u && e.v == v) || (e.u == v && e.v == u);
+    }), links.end());
+    adj_bandwidth[u][v] = adj_bandwidth[v][u] = 0;
+    int w_new = INF;
+    if (up.cost >= 0) {
+        links.push_back({u, v, up.cost, up.bandwidth});
+        adj_bandwidth[u][v] = adj_bandwidth[v][u] = up.bandwidth;
+        w_new = up.cost;
+    }
+    M = (int)links.size();
+    csr.build(N, links);
+    if (u == v) return 0;   // 自环不影响最短路
+
+    vector<char> changed = updateShortestPaths(u, v, w_old, w_new);
+
+    int updated = 0;
+    for (auto& t : tasks) {
+        if (!changed[t.start_node]) continue;
+        int d = dist[t.start_node][t.end_node];
+        if (d == INF) {
+            nodes[t.end_node].current_usage -= t.demand;
+            reassignTask(t);
+            d = dist[t.start_node][t.end_node];
+        }
+        int cost = d * t.demand;
+        if (cost != t.migration_cost) {
+            t.migration_cost = cost;
+            ++updated;
+        }
+    }
+    return updated;
+}
+
+// 读取 --link-updates 文件（每行 u v cost bandwidth，cost 为 -1 表示删除）并依次应用
+bool applyLinkUpdatesFile(const string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        cerr << "cannot open " << path << ": " << strerror(errno) << endl;
+        return false;
+    }
+    InputBuffer buf;
+    bool ok = buf.open(fd);
+    close(fd);
+    if (!ok) {
+        cerr << "cannot read " << path << ": " << strerror(errno) << endl;
+        return false;
+    }
+    IntScanner in(buf.data(), buf.data() + buf.size());
+    int f[4];
+    for (int i = 0; !in.atEnd(); ++i) {
+        if (!readFields(in, f, 4, "link update", i)) return false;
+        if (!checkNodeId(in, f[0], "link update", i) || !checkNodeId(in, f[1], "link update", i)) return false;
+        applyLinkUpdate({f[0], f[1], f[2], f[3]});
+    }
+    return true;
+}
 
 // 模拟迁移
-// 利用 next_hop 数组重构路径
+// 链路编号
+// 模拟按链路统计每个时间步的占用。每对相连的节点 {u, v} 对应一个稠密编号 0..E-1，
+// 每个节点的邻居按节点编号升序存放（CSR），查找 (u, v) 是在 u 的邻居段内二分。
+// 路径重构时为每一跳解析一次编号，模拟的内层循环只按编号下标访问扁平的计数数组。
+struct LinkIndex {
+    vector<int> offset;     // 长度 N + 2，下标为节点编号
+    vector<int> adj;        // 邻居节点，每段内升序
+    vector<int> id;         // 对应的链路编号
+    vector<int> bandwidth;  // 按编号的带宽（与 adj_bandwidth 一致，重复链路取最后一条）
+
+    void build() {
+        vector<pair<int, int>> pairs;
+        pairs.reserve(links.size());
+        for (const auto& e : links) {
+            if (e.u != e.v) pairs.push_back({min(e.u, e.v), max(e.u, e.v)});
+        }
+        sort(pairs.begin(), pairs.end());
+        pairs.erase(unique(pairs.begin(), pairs.end()), pairs.end());
+        offset.assign(N + 2, 0);
+        for (const auto& pr : pairs) {
+            offset[pr.first + 1]++;
+            offset[pr.second + 1]++;
+        }
+        for (int i = 1; i <= N + 1; ++i) offset[i] += offset[i - 1];
+        adj.resize(offset[N + 1]);
+        id.resize(offset[N + 1]);
+        bandwidth.resize(pairs.size());
+        vector<int> fill(offset.begin(), offset.end() - 1);
+        // pairs 按 (u, v) 升序：先为每个节点写入编号更小的邻居，再写入编号更大的邻居，各段因此升序
+        for (int k = 0; k < (int)pairs.size(); ++k) {
+            int u = pairs[k].first, v = pairs[k].second;
+            adj[fill[v]] = u;
+            id[fill[v]++] = k;
+        }
+        for (int k = 0; k < (int)pairs.size(); ++k) {
+            int u = pairs[k].first, v = pairs[k].second;
+            adj[fill[u]] = v;
+            id[fill[u]++] = k;
+            bandwidth[k] = adj_bandwidth[u][v];
+        }
+    }
+
+    int size() const { return (int)bandwidth.size(); }
+
+    // u-v 的链路编号，不相连时返回 -1
+    int find(int u, int v) const {
+        auto first = adj.begin() + offset[u], last = adj.begin() + offset[u + 1];
+        auto it = lower_bound(first, last, v);
+        return (it != last && *it == v) ? id[it - adj.begin()] : -1;
+    }
+};
+LinkIndex link_index;
+
+// 利用 next_hop 数组重构路径，并解析每一跳的链路编号
 void reconstructPath(Task& t) {
     if (t.start_node == t.end_node) return;
     int curr = t.start_node;
     while (curr != t.end_node) {
         int next = next_hop[curr][t.end_node];  
         t.path.push_back(next);     
+        t.path_link.push_back(link_index.find(curr, next));
         curr = next;    
     }
 }
 
-void simulateMigration() {
-    // 为所有需要移动的任务生成路径
+// 为所有需要移动的任务生成路径并重置模拟状态
+void preparePaths() {
+    ensureRoutes();
+    link_index.build();
     for (auto& t : tasks) {
+        t.path.clear();
+        t.path_link.clear();
         if (t.start_node != t.end_node) {
             reconstructPath(t);
             t.path_idx = 0;
@@ -284,48 +2198,106 @@ void simulateMigration() {
             t.finished = true;
         }
     }
+}
 
-    int current_time = 0;
-    bool any_unfinished = true;
+// 模拟停滞时报告滞留的任务数，以及它们等待的链路（至多列出前几条）
+static void reportStalled(const vector<vector<int>>& waiting, const vector<int>& active, int remaining, int time) {
+    cerr << "migration stalled at step " << time << ": " << remaining << " tasks cannot move" << endl;
+    const size_t SHOWN = 5;
+    for (size_t k = 0; k < active.size() && k < SHOWN; ++k) {
+        const Task& t = tasks[waiting[active[k]].front()];
+        int e = active[k];
+        cerr << "  " << waiting[e].size() << " waiting on link " << t.current_pos_node << "-" << t.path[t.path_idx]
+             << " (bandwidth " << link_index.bandwidth[e] << ")" << endl;
+    }
+}
 
-    while (any_unfinished) {
-        // 检查是否所有任务都已完成
-        any_unfinished = false;
-        for(const auto& t : tasks) {
-            if(!t.finished) {
-                any_unfinished = true;
-                break;
-            }
-        }
-        if (!any_unfinished) break;
+// 链路仲裁策略：同一条链路上的等待者按优先级 migrationPriority()（越小越先）放行，相同时按任务下标。
+// - index：只按任务下标，与最初逐个扫描任务的实现一致（默认）；
+// - longest-path：剩余跳数最多的先走，长路径任务不会被大量短路径任务挤在后面，缩短总步数；
+// - largest-demand：需求最大的任务先走；
+// - earliest-deadline：以任务在无拥塞时的到达时刻（路径总跳数）为截止时间，截止时间早的先走。
+// 优先级在任务入队时计算，在队列中等待期间不会变化。
+enum class SimPolicy { Index, LongestPath, LargestDemand, EarliestDeadline };
 
-        current_time++;
-        
-        // 记录当前这一秒，每条链路上的任务数量
-        map<int, int> link_usage;
-        // 记录这一秒成功获得移动权的任务下标
-        vector<int> tasks_moved_indices;
+static SimPolicy simPolicy(const string& name) {
+    if (name == "longest-path") return SimPolicy::LongestPath;
+    if (name == "largest-demand") return SimPolicy::LargestDemand;
+    if (name == "earliest-deadline") return SimPolicy::EarliestDeadline;
+    return SimPolicy::Index;
+}
 
-        // 遍历所有未完成任务，检查是否能移动
-        for (int i = 0; i < T; ++i) {
-            if (tasks[i].finished) continue;
+static int migrationPriority(const Task& t, SimPolicy policy) {
+    switch (policy) {
+    case SimPolicy::LongestPath: return -(int)(t.path.size() - t.path_idx);
+    case SimPolicy::LargestDemand: return -t.demand;
+    case SimPolicy::EarliestDeadline: return (int)t.path.size();
+    default: return 0;
+    }
+}
 
-            Task& t = tasks[i];
-            int u = t.current_pos_node;
-            int v = t.path[t.path_idx]; 
+// 事件驱动的迁移模拟
+// 每个时间步，等在同一条链路上的任务按仲裁策略的顺序获得通行权，每条链路至多放行其带宽个任务。
+// 等待中的任务挂在下一跳链路的队列 waiting[e] 上（按 (优先级, 任务下标) 的最小堆；默认策略下
+// 即按任务下标，与逐个扫描任务时的放行顺序一致），active 只包含队列非空的链路。每步只访问这些链路，从队首弹出至多带宽个任务；
+// 移动后的任务挂到其下一跳的队列上，到达终点则退出。因此不再每步扫描全部 T 个任务，
+// 开销与实际移动的跳数成正比，拥塞的长尾阶段只剩少数链路时尤其明显。
+// 同一步内移动的任务按下标排序后写日志，输出与按下标扫描全部任务的实现完全相同。
+// 各链路的队列合起来就是在途任务的紧凑集合（到达终点即出队），remaining 为尚未到达终点的任务数，
+// 循环以它为终止条件，不再扫描任务表。
+// 某一步没有任何任务能移动（例如路径上的链路带宽为 0）时停止，并在标准错误上报告滞留的任务。
+void simulateMigration() {
+    // 为所有需要移动的任务生成路径
+    preparePaths();
+    const SimPolicy policy = simPolicy(opt.sim_policy);
+    vector<int> priority(T, 0);
+    auto later = [&](int a, int b) {
+        return priority[a] != priority[b] ? priority[a] > priority[b] : a > b;
+    };
+    vector<vector<int>> waiting(link_index.size());
+    vector<int> active;
+    auto enqueue = [&](int i) {
+        const Task& t = tasks[i];
+        priority[i] = migrationPriority(t, policy);
+        vector<int>& q = waiting[t.path_link[t.path_idx]];
+        if (q.empty()) active.push_back(t.path_link[t.path_idx]);
+        q.push_back(i);
+        push_heap(q.begin(), q.end(), later);
+    };
+    int remaining = 0;
+    for (int i = 0; i < T; ++i) {
+        if (!tasks[i].finished) {
+            enqueue(i);
+            ++remaining;
+        }
+    }
 
-            int key = (u < v) ? (u * 1000 + v) : (v * 1000 + u);
-            int bw = adj_bandwidth[u][v];
+    // 记录这一秒成功获得移动权的任务下标
+    vector<int> tasks_moved_indices;
+    int current_time = 0;
 
-            if (link_usage[key] < bw) {
-                link_usage[key]++;
-                tasks_moved_indices.push_back(i);
+    while (remaining > 0) {
+        tasks_moved_indices.clear();
+        size_t kept = 0;
+        for (int e : active) {
+            vector<int>& q = waiting[e];
+            for (int k = 0; k < link_index.bandwidth[e] && !q.empty(); ++k) {
+                pop_heap(q.begin(), q.end(), later);
+                tasks_moved_indices.push_back(q.back());
+                q.pop_back();
             }
+            if (!q.empty()) active[kept++] = e;
         }
+        active.resize(kept);
 
-        if (tasks_moved_indices.empty() && any_unfinished) break; 
+        current_time++;
+        if (tasks_moved_indices.empty()) {
+            reportStalled(waiting, active, remaining, current_time);
+            break;
+        }
 
         // 执行移动
+        sort(tasks_moved_indices.begin(), tasks_moved_indices.end());
         for (int idx : tasks_moved_indices) {
             Task& t = tasks[idx];
             int from = t.current_pos_node;
@@ -338,6 +2310,9 @@ void simulateMigration() {
             
             if (t.path_idx >= t.path.size()) {
                 t.finished = true;
+                --remaining;
+            } else {
+                enqueue(idx);
             }
         }
     }
@@ -345,41 +2320,685 @@ void simulateMigration() {
 }
 
 // 输出
+// 缓冲输出
+// 整数用 to_chars 直接格式化进一块复用的大缓冲区，攒满后一次 write() 写出，
+// 避免逐行 endl 刷新带来的大量系统调用。析构时写出剩余内容。
+class OutputWriter {
+public:
+    explicit OutputWriter(int fd, size_t capacity = 1 << 20) : fd_(fd), buf_(capacity), pos_(0) {}
+    ~OutputWriter() { flush(); }
+
+    OutputWriter& putInt(long long v) {
+        reserve(24);
+        pos_ = to_chars(&buf_[pos_], &buf_[0] + buf_.size(), v).ptr - &buf_[0];
+        return *this;
+    }
+
+    OutputWriter& putChar(char c) {
+        reserve(1);
+        buf_[pos_++] = c;
+        return *this;
+    }
+
+    void flush() {
+        size_t done = 0;
+        while (done < pos_) {
+            ssize_t n = write(fd_, &buf_[done], pos_ - done);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                break;
+            }
+            done += n;
+        }
+        pos_ = 0;
+    }
+
+private:
+    void reserve(size_t n) {
+        if (pos_ + n > buf_.size()) flush();
+    }
+
+    int fd_;
+    vector<char> buf_;
+    size_t pos_;
+};
+
 void printOutput() {
-    vector<Task> sorted_tasks = tasks;
-    sort(sorted_tasks.begin(), sorted_tasks.end(), [](const Task& a, const Task& b){
-        return a.id < b.id;
+    // 只排序下标，避免拷贝带路径的任务对象
+    vector<int> order(tasks.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = (int)i;
+    stable_sort(order.begin(), order.end(), [](int a, int b) {
+        return tasks[a].id < tasks[b].id;
     });
 
+    OutputWriter out(STDOUT_FILENO);
     long long total_migration_cost = 0;
 
     // 输出任务分配详情
-    for (const auto& t : sorted_tasks) {
-        cout << t.id << " " << t.start_node << " " << t.end_node << " " << t.migration_cost << endl;
+    for (int idx : order) {
+        const Task& t = tasks[idx];
+        out.putInt(t.id).putChar(' ').putInt(t.start_node).putChar(' ').putInt(t.end_node).putChar(' ')
+           .putInt(t.migration_cost).putChar('\n');
         total_migration_cost += t.migration_cost;
     }
 
     // 输出各节点最终负载
     for (int i = 1; i <= N; ++i) {
-        cout << nodes[i].id << " " << nodes[i].current_usage << endl;
+        out.putInt(nodes[i].id).putChar(' ').putInt(nodes[i].current_usage).putChar('\n');
     }
 
-    cout << total_migration_cost << endl;
+    out.putInt(total_migration_cost).putChar('\n');
     
-    cout << total_time_steps << endl;
+    out.putInt(total_time_steps).putChar('\n');
     for (const auto& log : logs) {
-        cout << log.time << " " << log.task_id << " " << log.from << " " << log.to << endl;
+        out.putInt(log.time).putChar(' ').putInt(log.task_id).putChar(' ')
+           .putInt(log.from).putChar(' ').putInt(log.to).putChar('\n');
+    }
+}
+
+// 基准测试
+// 在随机生成的拓扑上对比各实现的耗时，并校验结果一致，结果输出到标准输出。
+
+// 生成 n 个节点、约 4n 条链路的连通随机拓扑（先连一棵随机树，再补随机边）
+static void generateRandomTopology(int n, unsigned seed) {
+    srand(seed);
+    N = n;
+    T = 0;
+    init();
+    for (int i = 1; i <= N; ++i) nodes[i] = {i, 0, 0};
+    auto randomLink = [](int u, int v) {
+        int c = rand() % 9 + 1;
+        addLink(u, v, c, rand() % 3 + 1);
+    };
+    for (int v = 2; v <= N; ++v) randomLink(rand() % (v - 1) + 1, v);
+    while ((int)links.size() < 4 * N) {
+        int u = rand() % N + 1, v = rand() % N + 1;
+        if (u != v) randomLink(u, v);
+    }
+    M = (int)links.size();
+}
+
+static double secondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// 将 dist / next_hop 的有效区域拷贝出来，便于重复计算与比对
+static void snapshotTables(vector<int>& d, vector<int>& nh) {
+    d.clear();
+    nh.clear();
+    for (int i = 1; i <= N; ++i) {
+        d.insert(d.end(), dist[i] + 1, dist[i] + N + 1);
+        nh.insert(nh.end(), next_hop[i] + 1, next_hop[i] + N + 1);
+    }
+}
+
+static void restoreTables(const vector<int>& d, const vector<int>& nh) {
+    for (int i = 1; i <= N; ++i) {
+        copy(d.begin() + (size_t)(i - 1) * N, d.begin() + (size_t)i * N, dist[i] + 1);
+        copy(nh.begin() + (size_t)(i - 1) * N, nh.begin() + (size_t)i * N, next_hop[i] + 1);
+    }
+}
+
+// 校验 next_hop 描述的每条路径长度都等于 dist
+static bool verifyRoutes() {
+    for (int i = 1; i <= N; ++i) {
+        for (int j = 1; j <= N; ++j) {
+            if (i == j || dist[i][j] == INF) continue;
+            long long len = 0;
+            int curr = i;
+            for (int steps = 0; curr != j; ++steps) {
+                if (steps > N) return false;
+                int nxt = next_hop[curr][j];
+                len += dist[curr][nxt];
+                curr = nxt;
+            }
+            if (len != dist[i][j]) return false;
+        }
+    }
+    return true;
+}
+
+void benchApsp() {
+    generateRandomTopology(opt.bench_nodes, 12345);
+    pool.resize(1);     // 先测单线程，多线程结果最后与之对比
+    vector<int> d0, nh0, d_ref, nh_ref, d_out, nh_out;
+    snapshotTables(d0, nh0);
+
+    // 基线：标量内核的经典三重循环
+    string chosen = minPlusKernelName;
+    selectMinPlusKernel("scalar");
+    auto start = chrono::steady_clock::now();
+    floydWarshall();
+    double base = secondsSince(start);
+    snapshotTables(d_ref, nh_ref);
+    cout << "apsp N=" << N << " M=" << M << endl;
+    cout << "classic scalar    " << fixed << setprecision(3) << base << " s" << endl;
+
+    // 各可用 SIMD 内核的经典三重循环，next_hop 须与标量版本逐项一致
+    for (const char* isa : {"avx2", "avx512"}) {
+        if (!selectMinPlusKernel(isa)) continue;
+        restoreTables(d0, nh0);
+        start = chrono::steady_clock::now();
+        floydWarshall();
+        double t = secondsSince(start);
+        snapshotTables(d_out, nh_out);
+        bool ok = (d_out == d_ref) && (nh_out == nh_ref);
+        cout << "classic " << setw(10) << left << isa << right
+             << t << " s  speedup " << setprecision(2) << base / t << "x"
+             << (ok ? "" : "  MISMATCH") << setprecision(3) << endl;
+    }
+
+    selectMinPlusKernel(chosen);
+    cout << "blocked kernel: " << minPlusKernelName << endl;
+    const int tiles[] = {16, 32, 64, 128, opt.tile};
+    vector<int> d_blocked, nh_blocked;
+    for (int tile : tiles) {
+        restoreTables(d0, nh0);
+        start = chrono::steady_clock::now();
+        floydWarshallBlocked(tile);
+        double t = secondsSince(start);
+        snapshotTables(d_out, nh_out);
+        bool ok = (d_out == d_ref) && verifyRoutes();
+        cout << "blocked tile=" << setw(4) << left << tile << right << " "
+             << t << " s  speedup " << setprecision(2) << base / t << "x"
+             << (ok ? "" : "  MISMATCH") << setprecision(3) << endl;
+        d_blocked = d_out;
+        nh_blocked = nh_out;
+    }
+
+    // 稀疏图 Dijkstra：dist 须一致，路由须为最短路
+    restoreTables(d0, nh0);
+    start = chrono::steady_clock::now();
+    dijkstraAllPairs();
+    double t = secondsSince(start);
+    vector<int> d_dijkstra, nh_dijkstra;
+    snapshotTables(d_dijkstra, nh_dijkstra);
+    bool ok = (d_dijkstra == d_ref) && verifyRoutes();
+    cout << "dijkstra          " << t << " s  speedup " << setprecision(2) << base / t << "x"
+         << (ok ? "" : "  MISMATCH") << setprecision(3) << endl;
+
+    // 按需引擎：任务集中在 N/64 个热点起点，终点取同样数量的热点；
+    // 校验起点行与 d_ref 一致，且热点之间的路由长度等于最短距离
+    vector<int> hot;
+    for (int v = 1; v <= N; v += 64) hot.push_back(v);
+    for (size_t i = 0; i < hot.size(); ++i) {
+        int from = hot[i], to = hot[hot.size() - 1 - i];
+        tasks.push_back({(int)i + 1, from, 1, to, 0, {}, {}, 0, from, false});
+    }
+    T = (int)tasks.size();
+    restoreTables(d0, nh0);
+    start = chrono::steady_clock::now();
+    lazySourceRows();
+    ensureRoutes();
+    t = secondsSince(start);
+    ok = true;
+    for (const auto& task : tasks) {
+        int s_node = task.start_node, e_node = task.end_node;
+        ok = ok && equal(dist[s_node] + 1, dist[s_node] + N + 1, d_ref.begin() + (size_t)(s_node - 1) * N);
+        long long len = 0;
+        for (int curr = s_node, steps = 0; curr != e_node && ok; ++steps) {
+            int nxt = next_hop[curr][e_node];
+            len += d_ref[(size_t)(curr - 1) * N + (nxt - 1)];
+            curr = nxt;
+            ok = steps <= N;
+        }
+        ok = ok && len == dist[s_node][e_node];
+    }
+    cout << "lazy S=" << setw(4) << left << hot.size() << right << "      " << t
+         << " s  speedup " << setprecision(2) << base / t << "x"
+         << (ok ? "" : "  MISMATCH") << setprecision(3) << endl;
+    tasks.clear();
+    T = 0;
+
+    // 多线程：结果须与同一引擎的单线程版本逐项一致
+    pool.resize(opt.threads);
+    if (pool.size() == 1) return;
+    const char* engines[] = {"classic", "blocked", "dijkstra"};
+    for (int e = 0; e < 3; ++e) {
+        restoreTables(d0, nh0);
+        start = chrono::steady_clock::now();
+        if (e == 0) floydWarshall();
+        else if (e == 1) floydWarshallBlocked(opt.tile);
+        else dijkstraAllPairs();
+        t = secondsSince(start);
+        snapshotTables(d_out, nh_out);
+        if (e == 0) ok = (d_out == d_ref && nh_out == nh_ref);
+        else if (e == 1) ok = (d_out == d_blocked && nh_out == nh_blocked);
+        else ok = (d_out == d_dijkstra && nh_out == nh_dijkstra);
+        cout << setw(8) << left << engines[e] << " threads=" << setw(3) << pool.size() << right
+             << " " << t << " s  speedup " << setprecision(2) << base / t << "x"
+             << (ok ? "" : "  MISMATCH") << setprecision(3) << endl;
+    }
+}
+
+// 生成与输入格式相同的文本：随机拓扑 + bench_tasks 个随机任务
+static string generateInputText(int n, int t, unsigned seed) {
+    generateRandomTopology(n, seed);
+    string text;
+    text.reserve((size_t)t * 16 + (size_t)M * 16);
+    text += to_string(N) + " " + to_string(M) + " " + to_string(t) + "\n";
+    for (int i = 1; i <= N; ++i) text += to_string(i) + " " + to_string(rand() % 1000 + 1) + "\n";
+    for (const auto& e : links) {
+        text += to_string(e.u) + " " + to_string(e.v) + " " + to_string(e.cost) + " " +
+                to_string(e.bandwidth) + "\n";
+    }
+    for (int i = 1; i <= t; ++i) {
+        text += to_string(i) + " " + to_string(rand() % N + 1) + " " + to_string(rand() % 50 + 1) + "\n";
+    }
+    return text;
+}
+
+void benchParse() {
+    string text = generateInputText(opt.bench_nodes, opt.bench_tasks, 12345);
+    cout << "parse " << text.size() / 1e6 << " MB, T=" << opt.bench_tasks << endl;
+
+    istringstream ss(text);
+    StreamReader stream(ss);
+    auto start = chrono::steady_clock::now();
+    bool ok = parseInput(stream);
+    double base = secondsSince(start);
+    vector<Task> ref = tasks;
+    cout << "istream >>  " << fixed << setprecision(3) << base << " s" << (ok ? "" : "  FAILED") << endl;
+
+    IntScanner scanner(text.data(), text.data() + text.size());
+    start = chrono::steady_clock::now();
+    ok = parseInput(scanner);
+    double t = secondsSince(start);
+    for (size_t i = 0; ok && i < tasks.size(); ++i) {
+        ok = tasks[i].id == ref[i].id && tasks[i].start_node == ref[i].start_node &&
+             tasks[i].demand == ref[i].demand;
+    }
+    cout << "scanner     " << t << " s  speedup " << setprecision(2) << base / t << "x"
+         << (ok && tasks.size() == ref.size() ? "" : "  MISMATCH") << endl;
+
+    // 二进制快照：编码一次，再从内存加载
+    vector<char> snapshot;
+    encodeSnapshot(snapshot);
+    start = chrono::steady_clock::now();
+    ok = loadSnapshot(snapshot.data(), snapshot.size());
+    t = secondsSince(start);
+    for (size_t i = 0; ok && i < tasks.size(); ++i) {
+        ok = tasks[i].id == ref[i].id && tasks[i].start_node == ref[i].start_node &&
+             tasks[i].demand == ref[i].demand;
+    }
+    cout << "snapshot    " << setprecision(3) << t << " s  speedup " << setprecision(2) << base / t << "x  ("
+         << snapshot.size() / 1e6 << " MB)" << (ok && tasks.size() == ref.size() ? "" : "  MISMATCH") << endl;
+}
+
+// 随机链路变更：与整表重算对比耗时并校验 dist 一致、路由为最短路
+void benchUpdate() {
+    generateRandomTopology(opt.bench_nodes, 12345);
+    dijkstraAllPairs();
+    const int ROUNDS = 200;
+    double incremental = 0, full = 0;
+    bool ok = true;
+    vector<int> d_inc, nh_inc, d_full, nh_full;
+    for (int r = 0; r < ROUNDS && ok; ++r) {
+        LinkUpdate up;
+        int kind = rand() % 3;
+        if (kind == 0) {            // 新增或替换为随机成本
+            up = {rand() % N + 1, rand() % N + 1, rand() % 9 + 1, rand() % 3 + 1};
+        } else {                    // 删除或修改一条已有链路
+            const Link& e = links[rand() % links.size()];
+            up = {e.u, e.v, kind == 1 ? -1 : rand() % 9 + 1, e.bandwidth};
+        }
+        auto start = chrono::steady_clock::now();
+        applyLinkUpdate(up);
+        incremental += secondsSince(start);
+        snapshotTables(d_inc, nh_inc);
+        ok = verifyRoutes();
+
+        start = chrono::steady_clock::now();
+        dijkstraAllPairs();
+        full += secondsSince(start);
+        snapshotTables(d_full, nh_full);
+        ok = ok && d_inc == d_full;
+    }
+    cout << "update N=" << N << " rounds=" << ROUNDS << endl;
+    cout << "full recompute " << fixed << setprecision(3) << full << " s" << endl;
+    cout << "incremental    " << incremental << " s  speedup " << setprecision(2) << full / incremental << "x"
+         << (ok ? "" : "  MISMATCH") << endl;
+}
+
+// 原始的退火内层循环（逐次读取 Task 对象与 dist 的随机行），仅供基准测试对比，返回迭代次数
+static long long annealReference(double time_limit) {
+    double current_temp = 2000.0;
+    long long current_cost = calculateTotalCost();
+    long long best_cost = current_cost;
+    vector<int> best_assignment(T);
+    for (int i = 0; i < T; ++i) best_assignment[i] = tasks[i].end_node;
+    clock_t start_clock = clock();
+    long long iter = 0;
+    while (true) {
+        if ((iter & 1023) == 0 && (double)(clock() - start_clock) / CLOCKS_PER_SEC > time_limit) break;
+        iter++;
+        Task& t = tasks[rand() % T];
+        int old_node = t.end_node;
+        int new_node = (rand() % N) + 1;
+        if (new_node == old_node || dist[t.start_node][new_node] == INF) continue;
+        if (nodes[new_node].current_usage + t.demand <= nodes[new_node].capacity) {
+            long long cost_diff = ((long long)dist[t.start_node][new_node] * t.demand) -
+                                  ((long long)dist[t.start_node][old_node] * t.demand);
+            if (cost_diff < 0 || exp(-cost_diff / current_temp) > ((double)rand() / RAND_MAX)) {
+                nodes[old_node].current_usage -= t.demand;
+                nodes[new_node].current_usage += t.demand;
+                t.end_node = new_node;
+                t.migration_cost = dist[t.start_node][new_node] * t.demand;
+                current_cost += cost_diff;
+                if (current_cost < best_cost) {
+                    best_cost = current_cost;
+                    for (int k = 0; k < T; ++k) best_assignment[k] = tasks[k].end_node;
+                }
+            }
+        }
+        current_temp *= 0.999;
+        if (current_temp < 1e-8) current_temp = 1000.0;
+    }
+    return iter;
+}
+
+// 模拟退火吞吐量：同一个贪心初解分别交给原始循环与当前实现，各运行相同时间，
+// 报告每秒尝试的移动次数、接受率以及最终总成本，并校验没有节点因退火而超出容量。
+void benchSa() {
+    string text = generateInputText(opt.bench_nodes, opt.bench_tasks, 12345);
+    IntScanner in(text.data(), text.data() + text.size());
+    if (!parseInput(in)) return;
+    computeShortestPaths();
+    solveAllocationGreedy();
+    const double SECONDS = opt.time_limit;
+    vector<Task> greedy = tasks;
+    vector<Node> greedy_nodes = nodes;
+    long long greedy_cost = calculateTotalCost();
+    vector<int> greedy_usage(N + 1, 0);    // 含贪心未能安置、留在起点的任务
+    for (const auto& t : tasks) greedy_usage[t.end_node] += t.demand;
+    cout << "sa N=" << N << " T=" << T << " greedy cost " << greedy_cost << endl;
+
+    long long iters = annealReference(SECONDS);
+    double base = iters / SECONDS;
+    cout << "reference       " << fixed << setprecision(0) << base << " moves/s" << endl;
+
+    // 依次为：均匀抽取、候选列表、候选列表 + 交换与逐出链（先用固定降温对比，再用自适应降温），
+    // 多线程时再加上每线程一个岛屿，最后是并行回火
+    const int k = opt.sa_candidates;
+    const string moves = opt.sa_moves;
+    const string schedule = opt.sa_schedule;
+    const int islands = opt.sa_islands;
+    struct Config { string label; int candidates; const char* moves; const char* schedule; int islands; bool tempering; };
+    vector<Config> configs = {{"uniform", 0, "relocate", "adaptive", 1, false},
+                              {"candidates", k, "relocate", "adaptive", 1, false},
+                              {"fixed schedule", k, "compound", "fixed", 1, false},
+                              {"compound", k, "compound", "adaptive", 1, false}};
+    if (pool.size() > 1) {
+        configs.push_back({"islands I=" + to_string(pool.size()), k, "compound", "adaptive", pool.size(), false});
+    }
+    configs.push_back({"tempering R=" + to_string(opt.pt_replicas), k, "compound", "adaptive", 1, true});
+    for (const auto& cfg : configs) {
+        if (k == 0 && cfg.candidates != 0) continue;
+        tasks = greedy;
+        nodes = greedy_nodes;
+        opt.sa_candidates = cfg.candidates;
+        opt.sa_moves = cfg.moves;
+        opt.sa_schedule = cfg.schedule;
+        opt.sa_islands = cfg.islands;
+        auto start = chrono::steady_clock::now();
+        SaStats stats = cfg.tempering ? optimizeAllocationPT(SECONDS) : optimizeAllocationSA(SECONDS);
+        double rate = stats.iterations / secondsSince(start);
+        long long cost = calculateTotalCost();
+        bool ok = cost <= greedy_cost;
+        for (int v = 1; v <= N; ++v) {
+            ok = ok && nodes[v].current_usage <= max(nodes[v].capacity, greedy_usage[v]);
+        }
+        cout << setw(16) << left << cfg.label << right << setprecision(0) << rate << " moves/s  speedup "
+             << setprecision(2) << rate / base << "x  accepted " << 100.0 * stats.accepted / stats.iterations
+             << "% (compound " << 100.0 * stats.compound / stats.iterations << "%)  cost " << cost
+             << (stats.migrations ? "  migrations " + to_string(stats.migrations) : "")
+             << (stats.exchange_attempts ? "  exchanges " + to_string(stats.exchanges) + "/" +
+                                           to_string(stats.exchange_attempts) : "")
+             << (ok ? "" : "  INVALID") << endl;
+    }
+    opt.sa_candidates = k;
+    opt.sa_moves = moves;
+    opt.sa_schedule = schedule;
+    opt.sa_islands = islands;
+
+    // 随机初解：前期几乎每次接受的移动都会刷新最优解，用于衡量记录最优解的开销
+    tasks = greedy;
+    for (auto& t : tasks) t.end_node = rand() % N + 1;
+    long long random_cost = calculateTotalCost();
+    auto start = chrono::steady_clock::now();
+    SaStats stats = optimizeAllocationSA(SECONDS);
+    cout << setw(16) << left << "random start" << right << setprecision(0) << stats.iterations / secondsSince(start)
+         << " moves/s  improvements " << stats.improvements << "  cost " << random_cost << " -> "
+         << calculateTotalCost() << endl;
+}
+
+// 原始的迁移模拟（每个时间步新建 map 按节点对统计链路占用），仅供基准测试对比。
+// 原实现的键 u * 1000 + v 在节点编号超过 999 时会冲突，这里改用 64 位键，结果与 simulateMigration() 一致。
+static void simulateReference() {
+    preparePaths();
+    int current_time = 0;
+    bool any_unfinished = true;
+    while (any_unfinished) {
+        any_unfinished = false;
+        for (const auto& t : tasks) {
+            if (!t.finished) {
+                any_unfinished = true;
+                break;
+            }
+        }
+        if (!any_unfinished) break;
+        current_time++;
+        map<long long, int> link_usage;
+        vector<int> tasks_moved_indices;
+        for (int i = 0; i < T; ++i) {
+            if (tasks[i].finished) continue;
+            Task& t = tasks[i];
+            int u = t.current_pos_node;
+            int v = t.path[t.path_idx];
+            long long key = (u < v) ? ((long long)u << 32 | v) : ((long long)v << 32 | u);
+            if (link_usage[key] < adj_bandwidth[u][v]) {
+                link_usage[key]++;
+                tasks_moved_indices.push_back(i);
+            }
+        }
+        if (tasks_moved_indices.empty()) break;
+        for (int idx : tasks_moved_indices) {
+            Task& t = tasks[idx];
+            logs.push_back({current_time, t.id, t.current_pos_node, t.path[t.path_idx]});
+            t.current_pos_node = t.path[t.path_idx];
+            t.path_idx++;
+            if (t.path_idx >= t.path.size()) t.finished = true;
+        }
     }
+    total_time_steps = current_time;
 }
 
-int main() {
+// 迁移模拟：每个任务随机指定一个不同于起点的终点（模拟不检查容量），使全部任务都要迁移；
+// 同一批任务分别交给原始实现与当前实现，对比耗时并校验日志与总步数一致
+void benchSim() {
+    string text = generateInputText(opt.bench_nodes, opt.bench_tasks, 12345);
+    IntScanner in(text.data(), text.data() + text.size());
+    if (!parseInput(in)) return;
+    computeShortestPaths();
+    for (auto& t : tasks) {
+        t.end_node = (t.start_node + rand() % (N - 1)) % N + 1;
+    }
+    vector<Task> planned = tasks;
+
+    logs.clear();
+    auto start = chrono::steady_clock::now();
+    simulateReference();
+    double base = secondsSince(start);
+    vector<LogEntry> ref_logs;
+    ref_logs.swap(logs);
+    int ref_steps = total_time_steps;
+    cout << "sim N=" << N << " T=" << T << " moves " << ref_logs.size() << " makespan " << ref_steps << endl;
+    cout << "reference   " << fixed << setprecision(3) << base << " s" << endl;
+
+    tasks = planned;
+    start = chrono::steady_clock::now();
+    simulateMigration();
+    double t = secondsSince(start);
+    bool ok = total_time_steps == ref_steps && logs.size() == ref_logs.size();
+    for (size_t i = 0; ok && i < logs.size(); ++i) {
+        ok = logs[i].time == ref_logs[i].time && logs[i].task_id == ref_logs[i].task_id &&
+             logs[i].from == ref_logs[i].from && logs[i].to == ref_logs[i].to;
+    }
+    cout << "event       " << t << " s  speedup " << setprecision(2) << base / t << "x" << (ok ? "" : "  MISMATCH")
+         << endl;
+
+    // 各仲裁策略的总步数
+    const string policy = opt.sim_policy;
+    for (const char* name : {"index", "longest-path", "largest-demand", "earliest-deadline"}) {
+        tasks = planned;
+        logs.clear();
+        opt.sim_policy = name;
+        start = chrono::steady_clock::now();
+        simulateMigration();
+        t = secondsSince(start);
+        cout << setw(18) << left << name << right << " makespan " << setw(6) << total_time_steps << "  "
+             << setprecision(3) << t << " s" << endl;
+    }
+    opt.sim_policy = policy;
+}
+
+// 命令行解析，支持 --name=value 与 --name value 两种写法；开关选项（--sa-stats）不带值
+static bool parseArgs(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        string name = arg, value;
+        size_t eq = arg.find('=');
+        if (eq != string::npos) {
+            name = arg.substr(0, eq);
+            value = arg.substr(eq + 1);
+        } else if (i + 1 < argc && name != "--sa-stats") {
+            value = argv[++i];
+        }
+
+        if (name == "--apsp") {
+            opt.apsp = value;
+            if (value != "auto" && value != "classic" && value != "blocked" && value != "dijkstra" && value != "lazy") {
+                cerr << "unknown --apsp engine: " << value << endl;
+                return false;
+            }
+        } else if (name == "--simd") {
+            opt.simd = value;
+            if (value != "auto" && value != "scalar" && value != "avx2" && value != "avx512") {
+                cerr << "unknown --simd kernel: " << value << endl;
+                return false;
+            }
+        } else if (name == "--apsp-cache") {
+            opt.apsp_cache = value;
+        } else if (name == "--link-updates") {
+            opt.link_updates = value;
+        } else if (name == "--sa-candidates") {
+            opt.sa_candidates = atoi(value.c_str());
+        } else if (name == "--time-limit") {
+            opt.time_limit = atof(value.c_str());
+        } else if (name == "--sa-iterations") {
+            opt.sa_iterations = strtoll(value.c_str(), nullptr, 10);
+        } else if (name == "--target-cost") {
+            opt.target_cost = strtoll(value.c_str(), nullptr, 10);
+        } else if (name == "--seed") {
+            opt.seed = strtoll(value.c_str(), nullptr, 10);
+        } else if (name == "--optimizer") {
+            opt.optimizer = value;
+            if (value != "sa" && value != "pt") {
+                cerr << "unknown --optimizer: " << value << endl;
+                return false;
+            }
+        } else if (name == "--pt-replicas") {
+            opt.pt_replicas = atoi(value.c_str());
+        } else if (name == "--sa-islands") {
+            opt.sa_islands = atoi(value.c_str());
+        } else if (name == "--sa-moves") {
+            opt.sa_moves = value;
+            if (value != "relocate" && value != "compound") {
+                cerr << "unknown --sa-moves type: " << value << endl;
+                return false;
+            }
+        } else if (name == "--sa-schedule") {
+            opt.sa_schedule = value;
+            if (value != "fixed" && value != "adaptive") {
+                cerr << "unknown --sa-schedule: " << value << endl;
+                return false;
+            }
+        } else if (name == "--sim-policy") {
+            opt.sim_policy = value;
+            if (value != "index" && value != "longest-path" && value != "largest-demand" &&
+                value != "earliest-deadline") {
+                cerr << "unknown --sim-policy: " << value << endl;
+                return false;
+            }
+        } else if (name == "--sa-stats") {
+            opt.sa_stats = (value.empty() || value == "1" || value == "on");
+        } else if (name == "--tile") {
+            opt.tile = atoi(value.c_str());
+        } else if (name == "--threads") {
+            opt.threads = atoi(value.c_str());
+        } else if (name == "--input") {
+            opt.input = value;
+        } else if (name == "--convert-binary") {
+            opt.convert_binary = value;
+        } else if (name == "--bench") {
+            opt.bench = value;
+        } else if (name == "--bench-nodes") {
+            opt.bench_nodes = atoi(value.c_str());
+        } else if (name == "--bench-tasks") {
+            opt.bench_tasks = atoi(value.c_str());
+        } else {
+            cerr << "unknown option: " << arg << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
     ios_base::sync_with_stdio(false);
     cin.tie(NULL);
 
-    readInput();
-    floydWarshall();            // 计算最短路径
+    if (!parseArgs(argc, argv)) return 1;
+    if (!selectMinPlusKernel(opt.simd)) {
+        cerr << "--simd=" << opt.simd << " is not supported by this CPU" << endl;
+        return 1;
+    }
+    pool.resize(opt.threads);
+    if (opt.bench == "apsp") {
+        benchApsp();
+        return 0;
+    }
+    if (opt.bench == "parse") {
+        benchParse();
+        return 0;
+    }
+    if (opt.bench == "update") {
+        benchUpdate();
+        return 0;
+    }
+    if (opt.bench == "sa") {
+        benchSa();
+        return 0;
+    }
+    if (opt.bench == "sim") {
+        benchSim();
+        return 0;
+    }
+    if (!opt.bench.empty()) {
+        cerr << "unknown benchmark: " << opt.bench << endl;
+        return 1;
+    }
+
+    if (!readInput()) return 1;
+    if (!opt.convert_binary.empty()) return writeSnapshot(opt.convert_binary) ? 0 : 1;
+    computeShortestPaths();     // 计算最短路径
     solveAllocationGreedy();    // 贪心初解
-    optimizeAllocationSA();     // 模拟退火优化
+    if (opt.optimizer == "pt") {
+        optimizeAllocationPT(opt.time_limit);   // 并行回火优化
+    } else {
+        optimizeAllocationSA(opt.time_limit);   // 模拟退火优化
+    }
+    if (!opt.link_updates.empty() && !applyLinkUpdatesFile(opt.link_updates)) return 1;
     simulateMigration();        // 模拟迁移过程
     printOutput();
 